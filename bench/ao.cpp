@@ -0,0 +1,53 @@
+// The AO-1xx grids, with every cell busy. The algorithms are spread across the
+// whole list, so that both the arithmetic and the transcendental ones are timed.
+#include "AO1.cpp"
+#include "bench.hpp"
+
+namespace {
+
+	template <unsigned int x, unsigned int y>
+	AO1<x, y> *createGrid(bool poly, bool fast, bool expressions) {
+		typedef AO1<x, y> M;
+		M *module = new M();
+		for (unsigned int i = 0; i < x * y; i++) {
+			if (expressions) {
+				module->params[M::PARAM_FUNC_1 + i].setValue(expressionFunction);
+				module->setExpression(i, "sin(x * 2) + y / c");
+			}
+			else {
+				module->params[M::PARAM_FUNC_1 + i].setValue(1 + (i * 37) % (expressionFunction - 1));
+			}
+			module->params[M::PARAM_CONST_1 + i].setValue(150 + i * 10);
+		}
+		module->params[M::PARAM_POLY].setValue(poly);
+		module->params[M::PARAM_FAST].setValue(fast);
+		return module;
+	}
+
+	template <unsigned int x, unsigned int y>
+	void benchGrid(const char *name) {
+		for (bool fast : { false, true }) {
+			std::string title = std::string(name) + (fast ? " fast" : " precise");
+			Module *module = createGrid<x, y>(false, fast, false);
+			Bench::connect(module, 1);
+			Bench::measure(title, 1, module);
+			for (int channels : { 4, 16 }) {
+				module = createGrid<x, y>(true, fast, false);
+				Bench::connect(module, channels);
+				Bench::measure(title + " poly", channels, module);
+			}
+		}
+	}
+
+} // end namespace
+
+void Bench::benchAO() {
+	benchGrid<6, 1>("AO-106");
+	benchGrid<6, 6>("AO-136");
+	Module *module = createGrid<6, 6>(false, false, true);
+	Bench::connect(module, 1);
+	Bench::measure("AO-136 expressions", 1, module);
+	module = createGrid<6, 6>(true, false, true);
+	Bench::connect(module, 16);
+	Bench::measure("AO-136 expressions poly", 16, module);
+}
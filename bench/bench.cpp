@@ -0,0 +1,105 @@
+#include <chrono>
+#include "bench.hpp"
+
+// Runs process() for a few modules against the stub engine and prints the time
+// taken per sample. Only the relative times mean anything: the stub engine
+// computes exp(), sin() and the like lane by lane where Rack uses SIMD, and there
+// is no real engine thread, cable graph or UI around the module.
+//
+// bench [filter] [frames]
+//	filter	only run the lines whose name starts with this, e.g. AO or DO-120
+//	frames	the number of samples timed for each line, 262144 by default
+
+namespace Bench {
+
+	namespace {
+		std::string filter;
+		unsigned int frames = 1 << 18;
+		float table[4096];
+	}
+
+	void connect(Module *module, int channels) {
+		for (Input &input : module->inputs) {
+			input.connect();
+			input.channels = channels;
+		}
+		for (Output &output : module->outputs)
+			output.connect();
+	}
+
+	float signal(unsigned int frame, int p, int c) {
+		return table[(frame + p * 389 + c * 97) & 4095];
+	}
+
+	float gate(unsigned int frame, int p, int c) {
+		unsigned int period = 128 + p * 48 + c * 16;
+		return ((frame + c * 7) % period < period / 2) ? 10.0f : 0.0f;
+	}
+
+	void feedSignals(Module *module, unsigned int frame) {
+		for (unsigned int p = 0; p < module->inputs.size(); p++) {
+			Input &input = module->inputs[p];
+			for (int c = 0; c < input.channels; c++)
+				input.setVoltage(signal(frame, p, c), c);
+		}
+	}
+
+	void feedGates(Module *module, unsigned int frame) {
+		for (unsigned int p = 0; p < module->inputs.size(); p++) {
+			Input &input = module->inputs[p];
+			for (int c = 0; c < input.channels; c++)
+				input.setVoltage(gate(frame, p, c), c);
+		}
+	}
+
+	void measure(const std::string &name, int channels, Module *module, Feed feed) {
+		if (name.compare(0, filter.size(), filter)) {
+			delete module;
+			return;
+		}
+		Module::ProcessArgs args;
+		args.sampleRate = APP->engine->getSampleRate();
+		args.sampleTime = APP->engine->getSampleTime();
+		module->onSampleRateChange();
+		// Long enough for anything compiled every few samples to be compiled
+		unsigned int frame = 0;
+		for (; frame < 4096; frame++) {
+			feed(module, frame);
+			module->process(args);
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int end = frame + frames; frame < end; frame++) {
+			feed(module, frame);
+			module->process(args);
+		}
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		double perSample = elapsed.count() / frames;
+		std::printf("%-32s %8d %12.1f %12.2f\n", name.c_str(), channels, perSample, perSample / channels);
+		delete module;
+	}
+
+} // namespace Bench
+
+int main(int argc, char *argv[]) {
+	if (argc > 1)
+		Bench::filter = argv[1];
+	if (argc > 2)
+		Bench::frames = std::max(1, std::atoi(argv[2]));
+	for (int i = 0; i < 4096; i++)
+		Bench::table[i] = (i < 2048) ? (i / 204.8f - 5.0f) : ((4096 - i) / 204.8f - 5.0f);
+	std::printf("%-32s %8s %12s %12s\n", "", "channels", "ns/sample", "ns/channel");
+
+	// What the feed and the virtual call cost on their own, with 8 inputs
+	for (int channels : { 1, 16 }) {
+		Module *empty = new Module();
+		empty->config(0, 8, 0);
+		Bench::connect(empty, channels);
+		Bench::measure("Feed only", channels, empty);
+	}
+
+	Bench::benchAO();
+	Bench::benchDO();
+	Bench::benchLA();
+	Bench::benchEO();
+	return 0;
+}
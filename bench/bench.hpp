@@ -0,0 +1,39 @@
+#pragma once
+#include "rack.hpp"
+
+using namespace rack;
+
+// A module under test is run by the stub engine at 48kHz. Before every frame the
+// feed writes its inputs, from a table of test signals, so that each run sees the
+// same signal from one build to the next.
+namespace Bench {
+
+	typedef std::function<void (Module *module, unsigned int frame)> Feed;
+
+	// Each input is connected with the given number of channels, and each output
+	// with one channel, as the engine does when a cable is plugged in.
+	void connect(Module *module, int channels);
+
+	// A slow triangle on channel c of input p, offset so that no two channels are
+	// in step. Between -5V and 5V.
+	float signal(unsigned int frame, int p, int c);
+
+	// A square wave on channel c of input p, 0V or 10V, with a period of a few
+	// hundred samples. For gates and triggers.
+	float gate(unsigned int frame, int p, int c);
+
+	// Writes signal() to every channel of every connected input
+	void feedSignals(Module *module, unsigned int frame);
+	void feedGates(Module *module, unsigned int frame);
+
+	// Runs process() for the module, and prints its name, the number of channels,
+	// and the time taken per sample, and per sample per channel. The module is
+	// deleted afterwards.
+	void measure(const std::string &name, int channels, Module *module, Feed feed = feedSignals);
+
+	void benchAO();
+	void benchDO();
+	void benchLA();
+	void benchEO();
+
+} // namespace Bench
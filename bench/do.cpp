@@ -0,0 +1,60 @@
+// The DO-1xx and DO-200 gate networks, wired as a chain in which each gate reads
+// the inputs and the gates before it, and the outputs come from the last gates,
+// so that nothing is folded away by the compiler.
+#include "DO1.cpp"
+#include "bench.hpp"
+
+namespace {
+
+	// The gate functions cycle through the whole list apart from NC. Connector
+	// values are 0 for nothing, 1 to x for the inputs, x + 1 for high, and
+	// x + 2 onwards for the outputs of the gates before.
+	template <unsigned int x, unsigned int y>
+	void wire(std::function<void (unsigned int, float)> set) {
+		typedef DONetwork<x, y> N;
+		for (unsigned int iy = 0; iy < y; iy++) {
+			set(N::NETLIST_GATE_1 + iy, 1 + (iy * 7) % (functions.size() - 1));
+			for (unsigned int i = 0; i < 4; i++) {
+				unsigned int choices = x + iy;
+				unsigned int val = 1 + (iy * 5 + i * 3) % choices;
+				set(N::NETLIST_CONNECTOR_1 + 4 * iy + i, (val > x) ? val + 1 : val);
+			}
+		}
+		for (unsigned int ix = 0; ix < x; ix++)
+			set(N::NETLIST_CONNECTOR_OUT_1 + ix, x + 1 + y - ix);
+	}
+
+	template <unsigned int x, unsigned int y>
+	DO1<x, y> *createDO1() {
+		DO1<x, y> *module = new DO1<x, y>();
+		wire<x, y>([=](unsigned int id, float value) { module->params[id].setValue(value); });
+		return module;
+	}
+
+	template <unsigned int x, unsigned int y>
+	DO2<x, y> *createDO2() {
+		DO2<x, y> *module = new DO2<x, y>();
+		wire<x, y>([=](unsigned int id, float value) { module->netlist[id] = value; });
+		module->checkNetlist();
+		return module;
+	}
+
+} // end namespace
+
+void Bench::benchDO() {
+	for (int channels : { 1, 4, 16 }) {
+		Module *module = createDO1<4, 5>();
+		Bench::connect(module, channels);
+		Bench::measure("DO-105", channels, module, Bench::feedGates);
+	}
+	for (int channels : { 1, 4, 16 }) {
+		Module *module = createDO1<4, 20>();
+		Bench::connect(module, channels);
+		Bench::measure("DO-120", channels, module, Bench::feedGates);
+	}
+	for (int channels : { 1, 4, 16 }) {
+		Module *module = createDO2<8, 200>();
+		Bench::connect(module, channels);
+		Bench::measure("DO-200", channels, module, Bench::feedGates);
+	}
+}
@@ -0,0 +1,17 @@
+// EO-102 sweeping both inputs, free running, with and without deep memory.
+#include "EO1.cpp"
+#include "bench.hpp"
+
+void Bench::benchEO() {
+	for (unsigned int deep : { 0, 16 }) {
+		for (int channels : { 1, 16 }) {
+			EO_102 *module = new EO_102();
+			module->poly = (channels > 1);
+			module->setDeep(deep);
+			Bench::connect(module, channels);
+			module->inputs[EO_102::INPUT_EXT].disconnect();
+			std::string name = module->poly ? "EO-102 poly" : "EO-102";
+			Bench::measure(deep ? name + " deep" : name, channels, module);
+		}
+	}
+}
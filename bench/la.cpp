@@ -0,0 +1,13 @@
+// LA-108 capturing gates on all 8 inputs, free running.
+#include "LA1.cpp"
+#include "bench.hpp"
+
+void Bench::benchLA() {
+	for (int channels : { 1, 8 }) {
+		LA_108 *module = new LA_108();
+		module->poly = (channels > 1);
+		Bench::connect(module, channels);
+		module->inputs[LA_108::INPUT_EXT].disconnect();
+		Bench::measure(module->poly ? "LA-108 poly" : "LA-108", channels, module, Bench::feedGates);
+	}
+}
@@ -0,0 +1,364 @@
+#include "bench.hpp"
+#include "shared/torpedo.hpp"
+
+// Torpedo loopback test. A RawOutputPort is wired straight into a RawInputPort
+// through the stub engine, one sample at a time, at 48kHz.
+//
+// First the throughput in bytes a second, and the latency in samples from send()
+// to received() on an idle link, are measured for each framing and several
+// message lengths. Every message must arrive intact.
+//
+// Then values are dropped, duplicated or corrupted on the link, in the header,
+// body or trailer of a message. The receiver must raise an error, must not pass
+// on the damaged message, and must pick up the message after it. No other
+// message may be lost or changed.
+//
+// Exits with 1 if anything fails.
+
+namespace {
+
+	const float SAMPLE_RATE = 48000.0f;
+
+	enum Framing {
+		FRAMING_SLOW,		// 1 channel
+		FRAMING_NARROW,		// 16 channels
+		FRAMING_WIDE,		// 16 channels, two bytes in each
+		FRAMING_LANES,		// 5 lanes of 3 channels
+		FRAMING_WIDE_LANES,	// 5 lanes of 3 channels, two bytes in each
+		NUM_FRAMINGS
+	};
+
+	const char *framingNames[NUM_FRAMINGS] = { "hiSpeed off", "hiSpeed on", "hiSpeed on, wide", "5 lanes", "5 lanes, wide" };
+
+	enum Faults {
+		FAULT_DROP,		// the value is lost, and the channel reads 0V
+		FAULT_DUPLICATE,	// the value before is repeated in its place
+		FAULT_CORRUPT,		// bit 0 of the byte is flipped
+		FAULT_CORRUPT_HIGH,	// bit 0 of the second byte of a wide value is flipped
+		NUM_FAULTS
+	};
+
+	const char *faultNames[NUM_FAULTS] = { "drop", "duplicate", "corrupt", "corrupt high byte" };
+
+	enum Sections {
+		SECTION_HEADER = 1,
+		SECTION_BODY = 2,
+		SECTION_TRAILER = 3
+	};
+
+	const char *sectionNames[4] = { "", "header", "body", "trailer" };
+
+	int failures = 0;
+
+	void fail(const std::string &text) {
+		std::printf("FAIL: %s\n", text.c_str());
+		failures++;
+	}
+
+	struct Delivery {
+		std::string appId;
+		std::string message;
+		uint64_t sample;
+	};
+
+	struct Sink : Torpedo::RawInputPort {
+		std::vector<Delivery> deliveries;
+		unsigned int errors[Torpedo::BasePort::ERROR_OVERSIZE + 1] = {};
+		unsigned int errorCount = 0;
+		uint64_t now = 0;
+
+		Sink(Module *module) : Torpedo::RawInputPort(module, 0) {}
+
+		void received(const std::string &appId, const std::string &message) override {
+			deliveries.push_back({ appId, message, now });
+		}
+		void error(unsigned int errorType) override {
+			errors[errorType]++;
+			errorCount++;
+		}
+	};
+
+	struct Fault {
+		unsigned int kind;
+		unsigned int section;
+		// The fault hits the first value of the section seen at or after this sample
+		uint64_t after;
+		uint64_t sample = 0;
+		bool done = false;
+	};
+
+	// The sending and receiving modules, and the link between them
+	struct Loop {
+		Framing framing;
+		Module tx;
+		Module rx;
+		std::vector<std::unique_ptr<Torpedo::RawOutputPort>> lanes;
+		Sink sink;
+		uint64_t now = 0;
+		Fault *fault = NULL;
+		float last = 0.0f;
+		// The lane each message was sent on
+		std::vector<unsigned int> sentOn;
+
+		Loop(Framing framing) : framing(framing), sink(&rx) {
+			tx.config(0, 0, 1);
+			rx.config(0, 1, 0);
+			tx.outputs[0].connect();
+			unsigned int count = isLanes() ? Torpedo::BasePort::MAX_LANES : 1;
+			for (unsigned int i = 0; i < count; i++) {
+				lanes.emplace_back(new Torpedo::RawOutputPort(&tx, 0));
+				lanes.back()->hiSpeed = (framing != FRAMING_SLOW);
+				lanes.back()->wide = (framing == FRAMING_WIDE || framing == FRAMING_WIDE_LANES);
+				lanes.back()->appId("TEST");
+			}
+		}
+
+		bool isLanes() {
+			return framing == FRAMING_LANES || framing == FRAMING_WIDE_LANES;
+		}
+
+		void step() {
+			if (isLanes()) {
+				Output &output = tx.outputs[0];
+				output.setChannels(16);
+				output.setVoltage(1.0f * (Torpedo::BasePort::LANE_MARKER | lanes.size()), 0);
+				unsigned int width = 15 / lanes.size();
+				for (unsigned int i = 0; i < lanes.size(); i++)
+					lanes[i]->processLane(1 + i * width, width);
+			}
+			else {
+				lanes[0]->process();
+			}
+			Input &input = rx.inputs[0];
+			input.channels = tx.outputs[0].channels;
+			std::memcpy(input.voltages, tx.outputs[0].voltages, sizeof(input.voltages));
+			if (fault && !fault->done && now >= fault->after)
+				inject();
+			// The value the next sample's first would duplicate
+			last = input.voltages[isLanes() ? 15 / lanes.size() : input.channels - 1];
+			sink.now = now;
+			sink.process();
+			now++;
+		}
+
+		// Damages the first value of the chosen section on the link. In lanes, only
+		// the first lane is touched.
+		void inject() {
+			Input &input = rx.inputs[0];
+			unsigned int first = isLanes() ? 1 : 0;
+			unsigned int end = isLanes() ? 1 + 15 / lanes.size() : input.channels;
+			for (unsigned int c = first; c < end; c++) {
+				unsigned int value = (unsigned int)input.voltages[c];
+				unsigned int section = (value >> 12) & 0x0f;
+				if (section == 4)
+					section = SECTION_BODY;
+				if (section != fault->section)
+					continue;
+				switch (fault->kind) {
+					case FAULT_DROP:
+						value = 0;
+						break;
+					case FAULT_DUPLICATE:
+						value = (unsigned int)((c > first) ? input.voltages[c - 1] : last);
+						break;
+					case FAULT_CORRUPT:
+						value ^= 0x01;
+						break;
+					case FAULT_CORRUPT_HIGH:
+						value ^= 0x10000;
+						break;
+				}
+				input.voltages[c] = 1.0f * value;
+				fault->sample = now;
+				fault->done = true;
+				return;
+			}
+		}
+
+		// Sends each message on the first lane that is free, as soon as one is, and runs
+		// until all have been delivered or could not have been
+		uint64_t run(const std::vector<std::string> &messages, uint64_t timeout) {
+			unsigned int next = 0;
+			while (now < timeout) {
+				for (unsigned int i = 0; i < lanes.size(); i++) {
+					if (next < messages.size() && !lanes[i]->isBusy()) {
+						lanes[i]->send(messages[next++]);
+						sentOn.push_back(i);
+					}
+				}
+				step();
+				if (next == messages.size() && sink.deliveries.size() >= messages.size())
+					break;
+				if (next == messages.size()) {
+					bool idle = true;
+					for (std::unique_ptr<Torpedo::RawOutputPort> &lane : lanes)
+						idle = idle && !lane->isBusy();
+					if (idle) {
+						// Let the receiver see the end of the last message
+						step();
+						break;
+					}
+				}
+			}
+			return now;
+		}
+	};
+
+	std::vector<std::string> makeMessages(unsigned int count, unsigned int length) {
+		std::vector<std::string> messages;
+		for (unsigned int i = 0; i < count; i++) {
+			std::string message = string::f("%u:", i);
+			while (message.size() < length)
+				message.push_back((char)(32 + (i * 31 + message.size() * 7) % 224));
+			messages.push_back(message.substr(0, std::max<size_t>(length, 3)));
+		}
+		return messages;
+	}
+
+	// Each message carries its index at the front
+	unsigned int indexOf(const std::string &message) {
+		return std::atoi(message.c_str());
+	}
+
+	bool framingIsWide(Framing framing) {
+		return framing == FRAMING_WIDE || framing == FRAMING_WIDE_LANES;
+	}
+
+	void measureThroughput() {
+		std::printf("%-20s %8s %14s %18s\n", "", "length", "bytes/s", "latency/samples");
+		for (int f = 0; f < NUM_FRAMINGS; f++) {
+			Framing framing = (Framing)f;
+			for (unsigned int length : { 16, 256, 4096 }) {
+				// Latency on an idle link
+				Loop idle(framing);
+				std::vector<std::string> one = makeMessages(1, length);
+				idle.run(one, 1 << 24);
+				if (idle.sink.deliveries.size() != 1 || idle.sink.deliveries[0].message != one[0]) {
+					fail(string::f("%s, %u bytes: not delivered on an idle link", framingNames[f], length));
+					continue;
+				}
+				uint64_t latency = idle.sink.deliveries[0].sample + 1;
+
+				// Throughput with the link kept busy
+				Loop busy(framing);
+				std::vector<std::string> messages = makeMessages(40, length);
+				uint64_t samples = busy.run(messages, 1 << 26);
+				bool intact = (busy.sink.deliveries.size() == messages.size());
+				uint64_t bytes = 0;
+				for (unsigned int i = 0; intact && i < messages.size(); i++) {
+					const std::string &message = busy.sink.deliveries[i].message;
+					intact = (indexOf(message) < messages.size()) && (message == messages[indexOf(message)]) && (busy.sink.deliveries[i].appId == "TEST");
+					bytes += message.size();
+				}
+				if (!intact || busy.sink.errorCount)
+					fail(string::f("%s, %u bytes: %u of %u delivered intact, %u errors", framingNames[f], length, (unsigned int)busy.sink.deliveries.size(), (unsigned int)messages.size(), busy.sink.errorCount));
+				std::printf("%-20s %8u %14.0f %18llu\n", framingNames[f], length, bytes * SAMPLE_RATE / samples, (unsigned long long)latency);
+			}
+		}
+	}
+
+	void injectFaults() {
+		std::printf("\n%-20s %-18s %-8s %6s %8s %14s\n", "", "fault", "in", "errors", "lost", "resync/samples");
+		for (int f = 0; f < NUM_FRAMINGS; f++) {
+			Framing framing = (Framing)f;
+			for (int kind = 0; kind < NUM_FAULTS; kind++) {
+				if (kind == FAULT_CORRUPT_HIGH && !framingIsWide(framing))
+					continue;
+				for (unsigned int section = SECTION_HEADER; section <= SECTION_TRAILER; section++) {
+					// The second byte of a wide value is only sent in the body
+					if (kind == FAULT_CORRUPT_HIGH && section != SECTION_BODY)
+						continue;
+					std::string name = string::f("%s, %s in %s", framingNames[f], faultNames[kind], sectionNames[section]);
+					Loop loop(framing);
+					// The fault hits one of the first few messages
+					std::vector<std::string> messages = makeMessages(12, 100);
+					Fault fault;
+					fault.kind = kind;
+					fault.section = section;
+					fault.after = (framing == FRAMING_SLOW) ? 150 : 12;
+					loop.fault = &fault;
+					loop.run(messages, 1 << 20);
+					if (!fault.done) {
+						fail(name + ": the fault was not injected");
+						continue;
+					}
+					std::vector<Delivery> &deliveries = loop.sink.deliveries;
+
+					// Anything delivered must be exactly what was sent
+					bool intact = true;
+					std::vector<bool> delivered(messages.size(), false);
+					for (Delivery &delivery : deliveries) {
+						unsigned int index = indexOf(delivery.message);
+						if (delivery.appId != "TEST" || index >= messages.size() || delivery.message != messages[index] || delivered[index])
+							intact = false;
+						else
+							delivered[index] = true;
+					}
+					unsigned int lost = messages.size() - deliveries.size();
+
+					// Resynchronised once the next message sent on the damaged lane arrives
+					unsigned int damaged = 0;
+					while (damaged < messages.size() && delivered[damaged])
+						damaged++;
+					uint64_t resync = 0;
+					for (Delivery &delivery : deliveries) {
+						unsigned int index = indexOf(delivery.message);
+						if (damaged < messages.size() && index > damaged && loop.sentOn[index] == loop.sentOn[damaged]) {
+							resync = delivery.sample - fault.sample;
+							break;
+						}
+					}
+					// A message of 100 bytes takes 124 values, or 62 when wide, and lanes may
+					// be waiting for the slowest of 5. Resynchronising should take no longer
+					// than sending the rest of the damaged message and the whole of the next.
+					uint64_t perMessage = (framingIsWide(framing) ? 74 : 124);
+					if (framing == FRAMING_NARROW || framing == FRAMING_WIDE)
+						perMessage = (perMessage + 15) / 16;
+					if (framing == FRAMING_LANES || framing == FRAMING_WIDE_LANES)
+						perMessage = (perMessage + 2) / 3;
+					uint64_t bound = 2 * perMessage + 2;
+
+					std::printf("%-20s %-18s %-8s %6u %8u %14llu\n", framingNames[f], faultNames[kind], sectionNames[section], loop.sink.errorCount, lost, (unsigned long long)resync);
+					if (!loop.sink.errorCount)
+						fail(name + ": no error was raised");
+					if (!intact)
+						fail(name + ": a damaged message was delivered");
+					if (lost != 1)
+						fail(string::f("%s: %u messages lost, rather than just the damaged one", name.c_str(), lost));
+					if (!resync || resync > bound)
+						fail(string::f("%s: resynchronised after %llu samples, more than %llu", name.c_str(), (unsigned long long)resync, (unsigned long long)bound));
+				}
+			}
+		}
+	}
+
+	// Messages longer than the receiver's limit are dropped with ERROR_OVERSIZE, and the
+	// message after is still received
+	void checkLimit() {
+		for (Framing framing : { FRAMING_NARROW, FRAMING_WIDE_LANES }) {
+			Loop loop(framing);
+			loop.sink.limit(64);
+			std::vector<std::string> messages = makeMessages(3, 32);
+			messages[1] = makeMessages(2, 200)[1];
+			loop.run(messages, 1 << 20);
+			std::string name = string::f("%s, over the limit", framingNames[framing]);
+			if (loop.sink.errors[Torpedo::BasePort::ERROR_OVERSIZE] != 1 || loop.sink.errorCount != 1)
+				fail(name + ": ERROR_OVERSIZE was not raised just once");
+			if (loop.sink.deliveries.size() != 2 || loop.sink.deliveries[0].message != messages[0] || loop.sink.deliveries[1].message != messages[2])
+				fail(name + ": the messages either side were not received");
+		}
+	}
+
+} // end namespace
+
+int main() {
+	measureThroughput();
+	injectFaults();
+	checkLimit();
+	if (failures) {
+		std::printf("\n%d failed\n", failures);
+		return 1;
+	}
+	std::printf("\nAll passed\n");
+	return 0;
+}
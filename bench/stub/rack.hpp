@@ -0,0 +1,410 @@
+// A stand-in for the parts of the Rack v1 engine that module process() code
+// touches, so that the benchmarks and the Torpedo loopback test can be built
+// without the SDK. Nothing here draws; sources built against it must be
+// compiled with SUBMARINE_HEADLESS so that their widgets are left out.
+
+#pragma once
+#include <cmath>
+#include <cfloat>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <smmintrin.h>
+
+#define DEBUG(...) do { std::fprintf(stderr, __VA_ARGS__); std::fprintf(stderr, "\n"); } while (0)
+#define INFO DEBUG
+#define WARN DEBUG
+
+// jansson, linked in as no-ops by stub.cpp. Nothing benchmarked saves a patch.
+typedef struct json_t json_t;
+typedef long long json_int_t;
+struct json_error_t { char text[160]; };
+json_t *json_object();
+json_t *json_array();
+json_t *json_string(const char *);
+json_t *json_integer(json_int_t);
+json_t *json_real(double);
+json_t *json_boolean(int);
+json_t *json_true();
+json_t *json_false();
+json_t *json_null();
+int json_object_set_new(json_t *, const char *, json_t *);
+int json_array_append_new(json_t *, json_t *);
+json_t *json_object_get(const json_t *, const char *);
+json_t *json_array_get(const json_t *, size_t);
+size_t json_array_size(const json_t *);
+const char *json_string_value(const json_t *);
+json_int_t json_integer_value(const json_t *);
+double json_real_value(const json_t *);
+double json_number_value(const json_t *);
+char *json_dumps(const json_t *, size_t);
+json_t *json_loads(const char *, size_t, json_error_t *);
+json_t *json_incref(json_t *);
+void json_decref(json_t *);
+inline bool json_is_string(const json_t *) { return false; }
+inline bool json_is_integer(const json_t *) { return false; }
+inline bool json_is_real(const json_t *) { return false; }
+inline bool json_is_number(const json_t *) { return false; }
+inline bool json_is_true(const json_t *) { return false; }
+inline bool json_is_false(const json_t *) { return false; }
+inline bool json_is_boolean(const json_t *) { return false; }
+inline bool json_is_object(const json_t *) { return false; }
+inline bool json_is_array(const json_t *) { return false; }
+#define json_array_foreach(array, index, value) \
+	for (index = 0; index < json_array_size(array) && (value = json_array_get(array, index)); index++)
+
+
+// The DO-1xx gate table carries each gate's drawing alongside its logic, so
+// the drawing calls it makes are declared here and do nothing.
+struct NVGcontext;
+struct NVGcolor { float r, g, b, a; };
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) { return NVGcolor{r / 255.f, g / 255.f, b / 255.f, 1.f}; }
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) { return NVGcolor{r / 255.f, g / 255.f, b / 255.f, a / 255.f}; }
+inline NVGcolor nvgRGBAf(float r, float g, float b, float a) { return NVGcolor{r, g, b, a}; }
+enum NVGalign { NVG_ALIGN_LEFT = 1, NVG_ALIGN_CENTER = 2, NVG_ALIGN_RIGHT = 4, NVG_ALIGN_TOP = 8, NVG_ALIGN_MIDDLE = 16, NVG_ALIGN_BOTTOM = 32, NVG_ALIGN_BASELINE = 64 };
+inline void nvgBeginPath(NVGcontext *) {}
+inline void nvgMoveTo(NVGcontext *, float, float) {}
+inline void nvgLineTo(NVGcontext *, float, float) {}
+inline void nvgBezierTo(NVGcontext *, float, float, float, float, float, float) {}
+inline void nvgQuadTo(NVGcontext *, float, float, float, float) {}
+inline void nvgRect(NVGcontext *, float, float, float, float) {}
+inline void nvgCircle(NVGcontext *, float, float, float) {}
+inline void nvgEllipse(NVGcontext *, float, float, float, float) {}
+inline void nvgFill(NVGcontext *) {}
+inline void nvgFillColor(NVGcontext *, NVGcolor) {}
+inline void nvgStroke(NVGcontext *) {}
+inline void nvgStrokeColor(NVGcontext *, NVGcolor) {}
+inline void nvgStrokeWidth(NVGcontext *, float) {}
+inline void nvgFontFaceId(NVGcontext *, int) {}
+inline void nvgFontSize(NVGcontext *, float) {}
+inline void nvgTextAlign(NVGcontext *, int) {}
+inline float nvgText(NVGcontext *, float x, float, const char *, const char *) { return x; }
+
+namespace rack {
+
+namespace string {
+	inline std::string f(const char *format, ...) {
+		char buf[1024];
+		va_list args;
+		va_start(args, format);
+		std::vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+		return buf;
+	}
+} // namespace string
+
+namespace math {
+	inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+	inline float clamp(float x, float a, float b) { return std::fmax(std::fmin(x, b), a); }
+	inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+	inline float crossfade(float a, float b, float p) { return a + (b - a) * p; }
+	inline bool isNear(float a, float b, float epsilon = 1e-6f) { return std::fabs(a - b) <= epsilon; }
+	inline int eucMod(int a, int b) { int m = a % b; return (m < 0) ? m + b : m; }
+	struct Vec {
+		float x = 0.f;
+		float y = 0.f;
+		Vec() {}
+		Vec(float x, float y) : x(x), y(y) {}
+	};
+} // namespace math
+using namespace math;
+
+namespace simd {
+	template <typename T, int N>
+	struct Vector;
+
+	template <>
+	struct Vector<float, 4> {
+		union { __m128 v; float s[4]; };
+		Vector() = default;
+		Vector(__m128 v) : v(v) {}
+		Vector(float x) { v = _mm_set1_ps(x); }
+		Vector(float a, float b, float c, float d) { v = _mm_setr_ps(a, b, c, d); }
+		float &operator[](int i) { return s[i]; }
+		const float &operator[](int i) const { return s[i]; }
+		static Vector load(const float *x) { return Vector(_mm_loadu_ps(x)); }
+		void store(float *x) { _mm_storeu_ps(x, v); }
+		static Vector zero() { return Vector(_mm_setzero_ps()); }
+		static Vector mask() { return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	};
+	typedef Vector<float, 4> float_4;
+
+	inline float_4 operator+(const float_4 &a, const float_4 &b) { return _mm_add_ps(a.v, b.v); }
+	inline float_4 operator-(const float_4 &a, const float_4 &b) { return _mm_sub_ps(a.v, b.v); }
+	inline float_4 operator*(const float_4 &a, const float_4 &b) { return _mm_mul_ps(a.v, b.v); }
+	inline float_4 operator/(const float_4 &a, const float_4 &b) { return _mm_div_ps(a.v, b.v); }
+	inline float_4 operator&(const float_4 &a, const float_4 &b) { return _mm_and_ps(a.v, b.v); }
+	inline float_4 operator|(const float_4 &a, const float_4 &b) { return _mm_or_ps(a.v, b.v); }
+	inline float_4 operator^(const float_4 &a, const float_4 &b) { return _mm_xor_ps(a.v, b.v); }
+	inline float_4 operator<(const float_4 &a, const float_4 &b) { return _mm_cmplt_ps(a.v, b.v); }
+	inline float_4 operator>(const float_4 &a, const float_4 &b) { return _mm_cmpgt_ps(a.v, b.v); }
+	inline float_4 operator<=(const float_4 &a, const float_4 &b) { return _mm_cmple_ps(a.v, b.v); }
+	inline float_4 operator>=(const float_4 &a, const float_4 &b) { return _mm_cmpge_ps(a.v, b.v); }
+	inline float_4 operator==(const float_4 &a, const float_4 &b) { return _mm_cmpeq_ps(a.v, b.v); }
+	inline float_4 operator!=(const float_4 &a, const float_4 &b) { return _mm_cmpneq_ps(a.v, b.v); }
+	inline float_4 operator-(const float_4 &a) { return 0.f - a; }
+	inline float_4 operator~(const float_4 &a) { return a ^ float_4::mask(); }
+	inline float_4 &operator+=(float_4 &a, const float_4 &b) { return a = a + b; }
+	inline float_4 &operator-=(float_4 &a, const float_4 &b) { return a = a - b; }
+	inline float_4 &operator*=(float_4 &a, const float_4 &b) { return a = a * b; }
+	inline float_4 &operator/=(float_4 &a, const float_4 &b) { return a = a / b; }
+	inline float_4 &operator&=(float_4 &a, const float_4 &b) { return a = a & b; }
+	inline float_4 &operator|=(float_4 &a, const float_4 &b) { return a = a | b; }
+	inline float_4 &operator^=(float_4 &a, const float_4 &b) { return a = a ^ b; }
+
+	inline float ifelse(bool c, float a, float b) { return c ? a : b; }
+	inline float_4 ifelse(float_4 m, float_4 a, float_4 b) { return _mm_blendv_ps(b.v, a.v, m.v); }
+	inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+	inline float_4 fabs(float_4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v); }
+	inline float_4 fmin(float_4 a, float_4 b) { return _mm_min_ps(a.v, b.v); }
+	inline float_4 fmax(float_4 a, float_4 b) { return _mm_max_ps(a.v, b.v); }
+	inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+	inline float_4 sqrt(float_4 a) { return _mm_sqrt_ps(a.v); }
+	inline float_4 rcp(float_4 a) { return _mm_rcp_ps(a.v); }
+	inline float_4 rsqrt(float_4 a) { return _mm_rsqrt_ps(a.v); }
+	inline float_4 floor(float_4 a) { return _mm_floor_ps(a.v); }
+	inline float_4 ceil(float_4 a) { return _mm_ceil_ps(a.v); }
+	inline float_4 round(float_4 a) { return _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline float_4 trunc(float_4 a) { return _mm_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+	inline float_4 fmod(float_4 a, float_4 b) { return a - trunc(a / b) * b; }
+	inline float_4 sgn(float_4 a) { return ifelse(a > 0.f, 1.f, ifelse(a < 0.f, -1.f, 0.f)); }
+
+	// Rack takes these from sse_mathfun; lane by lane through libm is close
+	// enough for relative timings between builds of this plugin.
+#define SUBMARINE_STUB_LANES(name, f) \
+	inline float_4 name(float_4 a) { return float_4(f(a[0]), f(a[1]), f(a[2]), f(a[3])); }
+	SUBMARINE_STUB_LANES(exp, std::exp)
+	SUBMARINE_STUB_LANES(log, std::log)
+	SUBMARINE_STUB_LANES(log2, std::log2)
+	SUBMARINE_STUB_LANES(log10, std::log10)
+	SUBMARINE_STUB_LANES(exp2, std::exp2)
+	SUBMARINE_STUB_LANES(sin, std::sin)
+	SUBMARINE_STUB_LANES(cos, std::cos)
+	SUBMARINE_STUB_LANES(tan, std::tan)
+	SUBMARINE_STUB_LANES(asin, std::asin)
+	SUBMARINE_STUB_LANES(acos, std::acos)
+	SUBMARINE_STUB_LANES(atan, std::atan)
+	SUBMARINE_STUB_LANES(sinh, std::sinh)
+	SUBMARINE_STUB_LANES(cosh, std::cosh)
+	SUBMARINE_STUB_LANES(tanh, std::tanh)
+#undef SUBMARINE_STUB_LANES
+	inline float_4 pow(float_4 a, float_4 b) { return float_4(std::pow(a[0], b[0]), std::pow(a[1], b[1]), std::pow(a[2], b[2]), std::pow(a[3], b[3])); }
+	inline float_4 atan2(float_4 a, float_4 b) { return float_4(std::atan2(a[0], b[0]), std::atan2(a[1], b[1]), std::atan2(a[2], b[2]), std::atan2(a[3], b[3])); }
+} // namespace simd
+using simd::float_4;
+
+namespace dsp {
+	inline float exp2_taylor5(float x) { return std::exp2(x); }
+
+	struct ClockDivider {
+		uint32_t clock = 0;
+		uint32_t division = 1;
+		void reset() { clock = 0; }
+		void setDivision(uint32_t d) { division = d; }
+		uint32_t getDivision() { return division; }
+		uint32_t getClock() { return clock; }
+		bool process() {
+			if (++clock >= division) {
+				clock = 0;
+				return true;
+			}
+			return false;
+		}
+	};
+
+	struct SchmittTrigger {
+		bool state = true;
+		void reset() { state = true; }
+		bool process(float in) {
+			if (state) {
+				if (in <= 0.f)
+					state = false;
+			}
+			else if (in >= 1.f) {
+				state = true;
+				return true;
+			}
+			return false;
+		}
+		bool isHigh() { return state; }
+	};
+
+	struct BooleanTrigger {
+		bool state = true;
+		void reset() { state = true; }
+		bool process(bool s) {
+			bool triggered = (s && !state);
+			state = s;
+			return triggered;
+		}
+	};
+
+	struct PulseGenerator {
+		float remaining = 0.f;
+		void reset() { remaining = 0.f; }
+		bool process(float deltaTime) {
+			if (remaining > 0.f) {
+				remaining -= deltaTime;
+				return true;
+			}
+			return false;
+		}
+		void trigger(float duration = 1e-3f) {
+			if (duration > remaining)
+				remaining = duration;
+		}
+	};
+} // namespace dsp
+
+namespace engine {
+	static const int PORT_MAX_CHANNELS = 16;
+
+	struct Param {
+		float value = 0.f;
+		float getValue() { return value; }
+		void setValue(float v) { value = v; }
+	};
+
+	struct Port {
+		union {
+			float voltages[PORT_MAX_CHANNELS] = {};
+			float value;
+		};
+		// As in Rack, a port is connected when it has channels. The engine
+		// sets an output to one channel when a cable is plugged in; the
+		// harnesses do the same by calling connect().
+		uint8_t channels = 0;
+		void connect() { if (!channels) channels = 1; }
+		void disconnect() { channels = 0; std::memset(voltages, 0, sizeof(voltages)); }
+		void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+		float getVoltage(int channel = 0) { return voltages[channel]; }
+		float getPolyVoltage(int channel) { return (channels == 1) ? getVoltage(0) : getVoltage(channel); }
+		float getNormalVoltage(float normalVoltage, int channel = 0) { return isConnected() ? getVoltage(channel) : normalVoltage; }
+		float getNormalPolyVoltage(float normalVoltage, int channel) { return isConnected() ? getPolyVoltage(channel) : normalVoltage; }
+		float *getVoltages(int firstChannel = 0) { return &voltages[firstChannel]; }
+		float getVoltageSum() {
+			float sum = 0.f;
+			for (int c = 0; c < channels; c++)
+				sum += voltages[c];
+			return sum;
+		}
+		template <typename T>
+		T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+		template <typename T>
+		T getPolyVoltageSimd(int firstChannel) { return (channels == 1) ? T(getVoltage(0)) : getVoltageSimd<T>(firstChannel); }
+		template <typename T>
+		T getNormalVoltageSimd(T normalVoltage, int firstChannel) { return isConnected() ? getVoltageSimd<T>(firstChannel) : normalVoltage; }
+		template <typename T>
+		T getNormalPolyVoltageSimd(T normalVoltage, int firstChannel) { return isConnected() ? getPolyVoltageSimd<T>(firstChannel) : normalVoltage; }
+		template <typename T>
+		void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+		void setChannels(int channels) {
+			// A disconnected output keeps 0 channels.
+			if (this->channels == 0)
+				return;
+			for (int c = channels; c < this->channels && c < PORT_MAX_CHANNELS; c++)
+				voltages[c] = 0.f;
+			if (channels == 0)
+				voltages[0] = 0.f;
+			this->channels = channels;
+		}
+		int getChannels() { return channels; }
+		bool isConnected() { return channels > 0; }
+		bool isMonophonic() { return channels == 1; }
+		bool isPolyphonic() { return channels > 1; }
+	};
+
+	struct Output : Port {};
+	struct Input : Port {};
+
+	struct Light {
+		float value = 0.f;
+		void setBrightness(float brightness) { value = brightness; }
+		float getBrightness() { return value; }
+		void setSmoothBrightness(float brightness, float deltaTime) {
+			value += (brightness - value) * std::min(deltaTime * 60.f, 1.f);
+		}
+		void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) {
+			value += (brightness - value) * std::min(deltaTime * lambda, 1.f);
+		}
+	};
+
+	struct Module {
+		int id = -1;
+		std::vector<Param> params;
+		std::vector<Input> inputs;
+		std::vector<Output> outputs;
+		std::vector<Light> lights;
+		bool bypass = false;
+
+		struct ProcessArgs {
+			float sampleRate;
+			float sampleTime;
+		};
+
+		virtual ~Module() {}
+		void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+			params.resize(numParams);
+			inputs.resize(numInputs);
+			outputs.resize(numOutputs);
+			lights.resize(numLights);
+		}
+		void configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string label = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+			params[paramId].value = defaultValue;
+		}
+		virtual void process(const ProcessArgs &args) {}
+		virtual void onAdd() {}
+		virtual void onRemove() {}
+		virtual void onReset() {}
+		virtual void onRandomize() {}
+		virtual void onSampleRateChange() {}
+		virtual json_t *dataToJson() { return NULL; }
+		virtual void dataFromJson(json_t *rootJ) {}
+	};
+} // namespace engine
+using namespace engine;
+
+namespace widget {
+	struct Widget {
+		struct DrawArgs {
+			NVGcontext *vg = NULL;
+		};
+	};
+} // namespace widget
+using namespace widget;
+
+namespace plugin {
+	struct Model;
+	struct Plugin {};
+} // namespace plugin
+using namespace plugin;
+
+// What the engine says about itself to modules that ask.
+struct StubEngine {
+	float sampleRate = 48000.f;
+	float getSampleRate() { return sampleRate; }
+	float getSampleTime() { return 1.f / sampleRate; }
+};
+struct StubContext {
+	StubEngine *engine;
+};
+StubContext *appGet();
+
+} // namespace rack
+
+#define APP rack::appGet()
+
+#define SVG_DPI 75.0
+#define SUBLIGHTBLUE nvgRGB(0x29,0xb2,0xef)
+struct StubScheme {
+	int font(NVGcontext *) { return 0; }
+};
+extern StubScheme gScheme;
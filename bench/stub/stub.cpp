@@ -0,0 +1,42 @@
+#include "rack.hpp"
+
+// Nothing that is benchmarked or tested loads or saves a patch, so jansson only
+// has to link.
+json_t *json_object() { return NULL; }
+json_t *json_array() { return NULL; }
+json_t *json_string(const char *) { return NULL; }
+json_t *json_integer(json_int_t) { return NULL; }
+json_t *json_real(double) { return NULL; }
+json_t *json_boolean(int) { return NULL; }
+json_t *json_true() { return NULL; }
+json_t *json_false() { return NULL; }
+json_t *json_null() { return NULL; }
+int json_object_set_new(json_t *, const char *, json_t *) { return 0; }
+int json_array_append_new(json_t *, json_t *) { return 0; }
+json_t *json_object_get(const json_t *, const char *) { return NULL; }
+json_t *json_array_get(const json_t *, size_t) { return NULL; }
+size_t json_array_size(const json_t *) { return 0; }
+const char *json_string_value(const json_t *) { return NULL; }
+json_int_t json_integer_value(const json_t *) { return 0; }
+double json_real_value(const json_t *) { return 0.0; }
+double json_number_value(const json_t *) { return 0.0; }
+char *json_dumps(const json_t *, size_t) { return NULL; }
+json_t *json_loads(const char *, size_t, json_error_t *error) {
+	if (error)
+		std::strcpy(error->text, "No jansson in the stub engine");
+	return NULL;
+}
+json_t *json_incref(json_t *json) { return json; }
+void json_decref(json_t *) {}
+
+StubScheme gScheme;
+
+namespace rack {
+
+StubContext *appGet() {
+	static StubEngine engine;
+	static StubContext context = { &engine };
+	return &context;
+}
+
+} // namespace rack
@@ -1,6 +1,11 @@
 //SubTag TM TW W11 W17 W23 W29 W41
 
 #include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include "SubmarineFree.hpp"
 
 namespace {
@@ -8,11 +13,184 @@ namespace {
 	static float FunctorClipboard = NAN;
 
 	typedef float (*func_t)(float, float, float);
+	typedef float_4 (*func4_t)(float_4, float_4, float_4);
 
 	struct Functor {
 		unsigned int category;
 		std::string name;
 		func_t func;
+		func4_t func4;
+		func_t fastFunc;
+		func4_t fastFunc4;
+	};
+
+	// Scalar and float_4 overloads of everything the functions table uses, so that each
+	// LAMBDA compiles to both a mono and a 4 channel polyphonic kernel. Transcendental
+	// functions are evaluated per lane with the same libm calls as the scalar path, so 
+	// every channel of a polyphonic cable gets exactly the result it would get in mono.
+	struct AOMath {
+
+		template <float (*f)(float)>
+		static float_4 lanes(float_4 a) {
+			return float_4(f(a[0]), f(a[1]), f(a[2]), f(a[3]));
+		}
+
+		template <float (*f)(float, float)>
+		static float_4 lanes(float_4 a, float_4 b) {
+			return float_4(f(a[0], b[0]), f(a[1], b[1]), f(a[2], b[2]), f(a[3], b[3]));
+		}
+
+#define AO_LANES(name) \
+		static float name(float a) { return std::name(a); } \
+		static float_4 name(float_4 a) { return lanes<name>(a); }
+
+		AO_LANES(sin)
+		AO_LANES(cos)
+		AO_LANES(tan)
+		AO_LANES(asin)
+		AO_LANES(acos)
+		AO_LANES(atan)
+		AO_LANES(log)
+		AO_LANES(log2)
+		AO_LANES(log10)
+		AO_LANES(exp)
+
+#undef AO_LANES
+
+		static float fmod(float a, float b) { return std::fmod(a, b); }
+		static float_4 fmod(float_4 a, float_4 b) { return lanes<fmod>(a, b); }
+		static float pow(float a, float b) { return std::pow(a, b); }
+		static float_4 pow(float_4 a, float_4 b) { return lanes<pow>(a, b); }
+
+		static float sqrt(float a) { return std::sqrt(a); }
+		static float_4 sqrt(float_4 a) { return simd::sqrt(a); }
+		static float abs(float a) { return std::fabs(a); }
+		static float_4 abs(float_4 a) { return simd::fabs(a); }
+		static float min(float a, float b) { return std::min(a, b); }
+		static float_4 min(float_4 a, float_4 b) { return simd::ifelse(b < a, b, a); }
+		static float max(float a, float b) { return std::max(a, b); }
+		static float_4 max(float_4 a, float_4 b) { return simd::ifelse(a < b, b, a); }
+		static float ifelse(bool mask, float a, float b) { return mask ? a : b; }
+		static float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return simd::ifelse(mask, a, b); }
+
+		static float truth(bool a) { return a ? 1.0f : 0.0f; }
+		static float_4 truth(float_4 a) { return simd::ifelse(a, 1.0f, 0.0f); }
+
+		static float finite(float a) { return std::isfinite(a) ? a : 0.0f; }
+		static float_4 finite(float_4 a) { return simd::ifelse((a >= -FLT_MAX) & (a <= FLT_MAX), a, 0.0f); }
+
+	};
+
+	// Polynomial approximations of the slower transcendental functions, used when a 
+	// module's Fast Math option is on. Everything is evaluated 4 lanes at a time with 
+	// no libm calls; the scalar versions are lane 0 of the float_4 versions so that mono
+	// and polyphonic patches still agree with each other. Coefficients are the minimax
+	// fits from Abramowitz and Stegun 4.4.49, 4.1.44 and 4.2.45. Worst case errors
+	// measured against double precision libm:
+	//
+	//   asin, acos         2.1e-7 / 3.7e-7 absolute
+	//   log, log2, log10   1.2e-6 absolute for normal numbers; denormals are treated as
+	//                      if their exponent was -127
+	//   exp                4e-7 relative for |x| < 5, 4e-6 at |x| = 80; results below 
+	//                      2^-126 flush to 0
+	//   pow                1e-6 relative for results between 1e-4 and 1e4, growing with
+	//                      |y * log2(x)| in the same way as exp
+	//
+	// sin, cos, tan and atan are not overridden; current libm versions of these are as
+	// fast as a polynomial of the same accuracy. Zero, negative arguments, infinities and
+	// NaN give the same results as libm, so Fast Math doesn't change which outputs the
+	// finite() guard zeroes.
+	struct AOFastMath : AOMath {
+
+		static float_4 arctan(float_4 a) {
+			float_4 ax = simd::fabs(a);
+			float_4 big = ax > 1.0f;
+			float_4 t = simd::ifelse(big, 1.0f / ax, ax);
+			float_4 t2 = t * t;
+			float_4 p = t * (1.0f + t2 * (-0.3333314528f + t2 * (0.1999355085f + t2 * (-0.1420889944f + t2 * (0.1065626393f + t2 * (-0.0752896400f + t2 * (0.0429096138f + t2 * (-0.0161657367f + t2 * 0.0028662257f))))))));
+			p = simd::ifelse(big, (float)M_PI_2 - p, p);
+			return simd::ifelse(a < 0.0f, -p, p);
+		}
+
+		static float_4 asin(float_4 a) { return arctan(a / simd::sqrt((1.0f - a) * (1.0f + a))); }
+		static float_4 acos(float_4 a) { return (float)M_PI_2 - asin(a); }
+
+		static float_4 lnMantissa(float_4 a, float_4 &exponent) {
+			// Split a into 2^exponent * m with m in [1, 2), and return ln(m)
+			__m128i bits = _mm_castps_si128(a.v);
+			exponent = float_4(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127))));
+			float_4 f = float_4(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)))) - 1.0f;
+			return f * (0.9999964239f + f * (-0.4998741238f + f * (0.3317990258f + f * (-0.2407338084f + f * (0.1676540711f + f * (-0.0953293897f + f * (0.0360884937f + f * -0.0064535442f)))))));
+		}
+
+		static float_4 logSpecial(float_4 a, float_4 r) {
+			// log of 0 is -inf, of negative numbers NaN, of inf inf; NaN fails every compare
+			r = simd::ifelse(a == INFINITY, a, r);
+			return simd::ifelse(a > 0.0f, r, simd::ifelse(a == 0.0f, -INFINITY, NAN));
+		}
+
+		static float_4 log(float_4 a) {
+			float_4 e;
+			float_4 m = lnMantissa(a, e);
+			return logSpecial(a, e * (float)M_LN2 + m);
+		}
+
+		static float_4 log2(float_4 a) {
+			float_4 e;
+			float_4 m = lnMantissa(a, e);
+			return logSpecial(a, e + m * (float)M_LOG2E);
+		}
+
+		static float_4 log10(float_4 a) {
+			float_4 e;
+			float_4 m = lnMantissa(a, e);
+			return logSpecial(a, e * (float)(M_LN2 / M_LN10) + m * (float)(1.0 / M_LN10));
+		}
+
+		static float_4 exp2(float_4 a) {
+			// 2^a = 2^(n - 1) * 2 * e^(-g ln 2) where n = floor(a) + 1 and g = n - a is in (0, 1]
+			float_4 t = simd::fmin(simd::fmax(a, -126.0f), 127.99999f);
+			__m128i i = _mm_cvttps_epi32(t.v);
+			float_4 fi = float_4(_mm_cvtepi32_ps(i));
+			float_4 adjust = fi > t;
+			i = _mm_add_epi32(i, _mm_castps_si128(adjust.v));
+			fi = simd::ifelse(adjust, fi - 1.0f, fi);
+			float_4 x = (fi + 1.0f - t) * (float)M_LN2;
+			float_4 p = 2.0f + x * (-1.9999999990f + x * (0.9999998412f + x * (-0.3333306038f + x * (0.0833146950f + x * (-0.0166027196f + x * (0.0026597640f + x * -0.0002826322f))))));
+			float_4 r = p * float_4(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23)));
+			r = simd::ifelse(a >= 128.0f, INFINITY, simd::ifelse(a < -126.0f, 0.0f, r));
+			return simd::ifelse(a == a, r, a);
+		}
+
+		static float_4 exp(float_4 a) { return exp2(a * (float)M_LOG2E); }
+
+		static float_4 pow(float_4 a, float_4 b) {
+			float_4 r = exp2(b * log2(simd::fabs(a)));
+			// Negative bases only have real powers for whole exponents, and every float at
+			// or beyond 2^24 is even
+			float_4 large = simd::fabs(b) >= 16777216.0f;
+			float_4 h = b * 0.5f;
+			float_4 hi = simd::ifelse(large, h, simd::floor(h));
+			float_4 whole = large | (b == simd::floor(b));
+			float_4 odd = whole & (h != hi);
+			r = simd::ifelse(a < 0.0f, simd::ifelse(whole, simd::ifelse(odd, -r, r), simd::ifelse(a == -INFINITY, r, NAN)), r);
+			return simd::ifelse((b == 0.0f) | (a == 1.0f), 1.0f, r);
+		}
+
+#define AO_FAST(name) \
+		static float name(float a) { return name(float_4(a))[0]; }
+
+		AO_FAST(asin)
+		AO_FAST(acos)
+		AO_FAST(log)
+		AO_FAST(log2)
+		AO_FAST(log10)
+		AO_FAST(exp)
+
+#undef AO_FAST
+
+		static float pow(float a, float b) { return pow(float_4(a), float_4(b))[0]; }
+
 	};
 
 	std::vector<std::string> categories {
@@ -35,10 +213,15 @@ namespace {
 		"Conditional Y and 0",
 		"Conditional X and Y",
 		"Conditional X and C",
-		"Conditional Y and C"
+		"Conditional Y and C",
+		"Expression"
 	};
 
-#define LAMBDA(e) [](float x, float y, float c)->float { return e ; }
+// Each row is compiled four times, mono and polyphonic, with precise and fast maths
+#define LAMBDA(e) [](float x, float y, float c)->float { typedef AOMath ao __attribute__((unused)); return e ; }, \
+		[](float_4 x, float_4 y, float_4 c)->float_4 { typedef AOMath ao __attribute__((unused)); return e ; }, \
+		[](float x, float y, float c)->float { typedef AOFastMath ao __attribute__((unused)); return e ; }, \
+		[](float_4 x, float_4 y, float_4 c)->float_4 { typedef AOFastMath ao __attribute__((unused)); return e ; }
 #define X "X"			// X
 #define Y "Y"			// Y
 #define C "C"			// C
@@ -134,12 +317,12 @@ namespace {
 		{ CATEGORY, Y D OP X A C CP,         	LAMBDA(  y / ( x + c )          ) },
 #undef CATEGORY
 #define CATEGORY 5
-		{ CATEGORY, OP X A C CP O Y,	   	LAMBDA(  fmodf( x + c , y )	   ) }, // Modulo
-		{ CATEGORY, OP Y A C CP O X,	   	LAMBDA(  fmodf( y + c , x )	   ) },
-		{ CATEGORY, X O OP Y A C CP,	   	LAMBDA(  fmodf( x , y + c )	   ) },
-		{ CATEGORY, Y O OP X A C CP,	   	LAMBDA(  fmodf( y , x + c)	   ) },
-		{ CATEGORY, X O C,		   	LAMBDA(  fmodf( x , c )	   ) },
-		{ CATEGORY, Y O C,		   	LAMBDA(  fmodf( y , c )  	   ) },
+		{ CATEGORY, OP X A C CP O Y,	   	LAMBDA(  ao::fmod( x + c , y )	   ) }, // Modulo
+		{ CATEGORY, OP Y A C CP O X,	   	LAMBDA(  ao::fmod( y + c , x )	   ) },
+		{ CATEGORY, X O OP Y A C CP,	   	LAMBDA(  ao::fmod( x , y + c )	   ) },
+		{ CATEGORY, Y O OP X A C CP,	   	LAMBDA(  ao::fmod( y , x + c)	   ) },
+		{ CATEGORY, X O C,		   	LAMBDA(  ao::fmod( x , c )	   ) },
+		{ CATEGORY, Y O C,		   	LAMBDA(  ao::fmod( y , c )  	   ) },
 #undef CATEGORY
 #define CATEGORY 6
 		{ CATEGORY, X S2 A C,                	LAMBDA(  x * x + c              ) }, // Quadratic
@@ -152,179 +335,183 @@ namespace {
 		{ CATEGORY, Y S2 A C X,              	LAMBDA(  y * y + c * x          ) },
 #undef CATEGORY
 #define CATEGORY 7
-		{ CATEGORY, R OP X A C CP,           	LAMBDA(  sqrt( x + c )          ) }, // Square Root
-		{ CATEGORY, R OP Y A C CP,           	LAMBDA(  sqrt( y + c )          ) },
+		{ CATEGORY, R OP X A C CP,           	LAMBDA(  ao::sqrt( x + c )          ) }, // Square Root
+		{ CATEGORY, R OP Y A C CP,           	LAMBDA(  ao::sqrt( y + c )          ) },
 #undef CATEGORY
 #define CATEGORY 8
-		{ CATEGORY, C SX,			LAMBDA(  powf( c , x )	   ) }, // Powers
-		{ CATEGORY, C SY,			LAMBDA(  powf( c , y )	   ) },
-		{ CATEGORY, C SX SA SY,		   	LAMBDA(  powf( c , x + y ) 	   ) },
-		{ CATEGORY, C SX SY,		   	LAMBDA(  powf( c , x * y )	   ) },
-		{ CATEGORY, X SC,			LAMBDA(  powf( x , c ) 	   ) },
-		{ CATEGORY, Y SC,			LAMBDA(  powf( y , c )	   ) },
-		{ CATEGORY, X SY SA SC, 		LAMBDA(  powf( x , y + c )	   ) },
-		{ CATEGORY, Y SX SA SC,		   	LAMBDA(  powf( y , x + c )	   ) },
-		{ CATEGORY, X SC SY,		   	LAMBDA(  powf( x , c * y )	   ) },
-		{ CATEGORY, Y SC SX,		   	LAMBDA(  powf( y , c * x )	   ) },
+		{ CATEGORY, C SX,			LAMBDA(  ao::pow( c , x )	   ) }, // Powers
+		{ CATEGORY, C SY,			LAMBDA(  ao::pow( c , y )	   ) },
+		{ CATEGORY, C SX SA SY,		   	LAMBDA(  ao::pow( c , x + y ) 	   ) },
+		{ CATEGORY, C SX SY,		   	LAMBDA(  ao::pow( c , x * y )	   ) },
+		{ CATEGORY, X SC,			LAMBDA(  ao::pow( x , c ) 	   ) },
+		{ CATEGORY, Y SC,			LAMBDA(  ao::pow( y , c )	   ) },
+		{ CATEGORY, X SY SA SC, 		LAMBDA(  ao::pow( x , y + c )	   ) },
+		{ CATEGORY, Y SX SA SC,		   	LAMBDA(  ao::pow( y , x + c )	   ) },
+		{ CATEGORY, X SC SY,		   	LAMBDA(  ao::pow( x , c * y )	   ) },
+		{ CATEGORY, Y SC SX,		   	LAMBDA(  ao::pow( y , c * x )	   ) },
 #undef CATEGORY
 #define CATEGORY 9
-                { CATEGORY, P X A C P,               	LAMBDA(  std::abs( x + c )           ) }, // Modulus
-		{ CATEGORY, P Y A C P,               	LAMBDA(  std::abs( y + c )           ) },
+                { CATEGORY, P X A C P,               	LAMBDA(  ao::abs( x + c )           ) }, // Modulus
+		{ CATEGORY, P Y A C P,               	LAMBDA(  ao::abs( y + c )           ) },
 #undef CATEGORY
 #define CATEGORY 10
-		{ CATEGORY, MIN OP X A C COMMA Y CP, 	LAMBDA(  std::min( x + c, y )   ) }, // Minmax
-		{ CATEGORY, MIN OP X COMMA C CP,     	LAMBDA(  std::min( x, c )       ) },
-      		{ CATEGORY, MIN OP Y COMMA C CP,     	LAMBDA(  std::min( y, c )       ) },
-     		{ CATEGORY, MAX OP X A C COMMA Y CP, 	LAMBDA(  std::max( x + c, y )   ) },
-		{ CATEGORY, MAX OP X COMMA C CP,     	LAMBDA(  std::max( x, c )       ) },
-		{ CATEGORY, MAX OP Y COMMA C CP,     	LAMBDA(  std::max( y, c )       ) },
+		{ CATEGORY, MIN OP X A C COMMA Y CP, 	LAMBDA(  ao::min( x + c, y )   ) }, // Minmax
+		{ CATEGORY, MIN OP X COMMA C CP,     	LAMBDA(  ao::min( x, c )       ) },
+      		{ CATEGORY, MIN OP Y COMMA C CP,     	LAMBDA(  ao::min( y, c )       ) },
+     		{ CATEGORY, MAX OP X A C COMMA Y CP, 	LAMBDA(  ao::max( x + c, y )   ) },
+		{ CATEGORY, MAX OP X COMMA C CP,     	LAMBDA(  ao::max( x, c )       ) },
+		{ CATEGORY, MAX OP Y COMMA C CP,     	LAMBDA(  ao::max( y, c )       ) },
 #undef CATEGORY
 #define CATEGORY 11
-		{ CATEGORY, SIN OP X A C CP,         	LAMBDA(  sin( x + c )           ) }, // Trigonometric
-		{ CATEGORY, SIN OP Y A C CP,         	LAMBDA(  sin( y + c )           ) },
-		{ CATEGORY, SIN OP X A Y CP,         	LAMBDA(  sin( x + y )           ) },
- 		{ CATEGORY, SIN OP C X CP,           	LAMBDA(  sin( c * x )           ) },
-		{ CATEGORY, SIN OP C Y CP,           	LAMBDA(  sin( c * y )           ) },
-		{ CATEGORY, SIN OP X Y CP,           	LAMBDA(  sin( x * y )           ) },
-		{ CATEGORY, COS OP X A C CP,         	LAMBDA(  cos( x + c )           ) },
-		{ CATEGORY, COS OP Y A C CP,         	LAMBDA(  cos( y + c )           ) },
-		{ CATEGORY, COS OP X A Y CP,         	LAMBDA(  cos( x + y )           ) },
- 		{ CATEGORY, COS OP C X CP,           	LAMBDA(  cos( c * x )           ) },
-		{ CATEGORY, COS OP C Y CP,           	LAMBDA(  cos( c * y )           ) },
-		{ CATEGORY, COS OP X Y CP,           	LAMBDA(  cos( x * y )           ) },
-		{ CATEGORY, TAN OP X A C CP,         	LAMBDA(  tan( x + c )           ) },
-		{ CATEGORY, TAN OP Y A C CP,         	LAMBDA(  tan( y + c )           ) },
-		{ CATEGORY, TAN OP X A Y CP,         	LAMBDA(  tan( x + y )           ) },
- 		{ CATEGORY, TAN OP C X CP,           	LAMBDA(  tan( c * x )           ) },
-		{ CATEGORY, TAN OP C Y CP,           	LAMBDA(  tan( c * y )           ) },
-		{ CATEGORY, TAN OP X Y CP,           	LAMBDA(  tan( x * y )           ) },
+		{ CATEGORY, SIN OP X A C CP,         	LAMBDA(  ao::sin( x + c )           ) }, // Trigonometric
+		{ CATEGORY, SIN OP Y A C CP,         	LAMBDA(  ao::sin( y + c )           ) },
+		{ CATEGORY, SIN OP X A Y CP,         	LAMBDA(  ao::sin( x + y )           ) },
+ 		{ CATEGORY, SIN OP C X CP,           	LAMBDA(  ao::sin( c * x )           ) },
+		{ CATEGORY, SIN OP C Y CP,           	LAMBDA(  ao::sin( c * y )           ) },
+		{ CATEGORY, SIN OP X Y CP,           	LAMBDA(  ao::sin( x * y )           ) },
+		{ CATEGORY, COS OP X A C CP,         	LAMBDA(  ao::cos( x + c )           ) },
+		{ CATEGORY, COS OP Y A C CP,         	LAMBDA(  ao::cos( y + c )           ) },
+		{ CATEGORY, COS OP X A Y CP,         	LAMBDA(  ao::cos( x + y )           ) },
+ 		{ CATEGORY, COS OP C X CP,           	LAMBDA(  ao::cos( c * x )           ) },
+		{ CATEGORY, COS OP C Y CP,           	LAMBDA(  ao::cos( c * y )           ) },
+		{ CATEGORY, COS OP X Y CP,           	LAMBDA(  ao::cos( x * y )           ) },
+		{ CATEGORY, TAN OP X A C CP,         	LAMBDA(  ao::tan( x + c )           ) },
+		{ CATEGORY, TAN OP Y A C CP,         	LAMBDA(  ao::tan( y + c )           ) },
+		{ CATEGORY, TAN OP X A Y CP,         	LAMBDA(  ao::tan( x + y )           ) },
+ 		{ CATEGORY, TAN OP C X CP,           	LAMBDA(  ao::tan( c * x )           ) },
+		{ CATEGORY, TAN OP C Y CP,           	LAMBDA(  ao::tan( c * y )           ) },
+		{ CATEGORY, TAN OP X Y CP,           	LAMBDA(  ao::tan( x * y )           ) },
 #undef CATEGORY
 #define CATEGORY 12
-		{ CATEGORY, ASIN OP X A C CP,        	LAMBDA(  asin( x + c )          ) }, // Inverse Trigonometric
-		{ CATEGORY, ASIN OP Y A C CP,        	LAMBDA(  asin( y + c )          ) },
-		{ CATEGORY, ASIN OP X A Y CP,        	LAMBDA(  asin( x + y )          ) },
- 		{ CATEGORY, ASIN OP C X CP,          	LAMBDA(  asin( c * x )          ) },
-		{ CATEGORY, ASIN OP C Y CP,          	LAMBDA(  asin( c * y )          ) },
-		{ CATEGORY, ASIN OP X Y CP,          	LAMBDA(  asin( x * y )          ) },
-		{ CATEGORY, ACOS OP X A C CP,        	LAMBDA(  acos( x + c )          ) },
-		{ CATEGORY, ACOS OP Y A C CP,        	LAMBDA(  acos( y + c )          ) },
-		{ CATEGORY, ACOS OP X A Y CP,        	LAMBDA(  acos( x + y )          ) },
- 		{ CATEGORY, ACOS OP C X CP,          	LAMBDA(  acos( c * x )          ) },
-		{ CATEGORY, ACOS OP C Y CP,          	LAMBDA(  acos( c * y )          ) },
-		{ CATEGORY, ACOS OP X Y CP,          	LAMBDA(  acos( x * y )          ) },
-		{ CATEGORY, ATAN OP X A C CP,        	LAMBDA(  atan( x + c )          ) },
-		{ CATEGORY, ATAN OP Y A C CP,        	LAMBDA(  atan( y + c )          ) },
-		{ CATEGORY, ATAN OP X A Y CP,        	LAMBDA(  atan( x + y )          ) },
- 		{ CATEGORY, ATAN OP C X CP,          	LAMBDA(  atan( c * x )          ) },
-		{ CATEGORY, ATAN OP C Y CP,          	LAMBDA(  atan( c * y )          ) },
-		{ CATEGORY, ATAN OP X Y CP,          	LAMBDA(  atan( x * y )          ) },
+		{ CATEGORY, ASIN OP X A C CP,        	LAMBDA(  ao::asin( x + c )          ) }, // Inverse Trigonometric
+		{ CATEGORY, ASIN OP Y A C CP,        	LAMBDA(  ao::asin( y + c )          ) },
+		{ CATEGORY, ASIN OP X A Y CP,        	LAMBDA(  ao::asin( x + y )          ) },
+ 		{ CATEGORY, ASIN OP C X CP,          	LAMBDA(  ao::asin( c * x )          ) },
+		{ CATEGORY, ASIN OP C Y CP,          	LAMBDA(  ao::asin( c * y )          ) },
+		{ CATEGORY, ASIN OP X Y CP,          	LAMBDA(  ao::asin( x * y )          ) },
+		{ CATEGORY, ACOS OP X A C CP,        	LAMBDA(  ao::acos( x + c )          ) },
+		{ CATEGORY, ACOS OP Y A C CP,        	LAMBDA(  ao::acos( y + c )          ) },
+		{ CATEGORY, ACOS OP X A Y CP,        	LAMBDA(  ao::acos( x + y )          ) },
+ 		{ CATEGORY, ACOS OP C X CP,          	LAMBDA(  ao::acos( c * x )          ) },
+		{ CATEGORY, ACOS OP C Y CP,          	LAMBDA(  ao::acos( c * y )          ) },
+		{ CATEGORY, ACOS OP X Y CP,          	LAMBDA(  ao::acos( x * y )          ) },
+		{ CATEGORY, ATAN OP X A C CP,        	LAMBDA(  ao::atan( x + c )          ) },
+		{ CATEGORY, ATAN OP Y A C CP,        	LAMBDA(  ao::atan( y + c )          ) },
+		{ CATEGORY, ATAN OP X A Y CP,        	LAMBDA(  ao::atan( x + y )          ) },
+ 		{ CATEGORY, ATAN OP C X CP,          	LAMBDA(  ao::atan( c * x )          ) },
+		{ CATEGORY, ATAN OP C Y CP,          	LAMBDA(  ao::atan( c * y )          ) },
+		{ CATEGORY, ATAN OP X Y CP,          	LAMBDA(  ao::atan( x * y )          ) },
 #undef CATEGORY
 #define CATEGORY 13
-		{ CATEGORY, LOG OP X A C CP,         	LAMBDA(  log( x + c )           ) }, // Logarithmic
-		{ CATEGORY, LOG OP Y A C CP,         	LAMBDA(  log( y + c )           ) },
-		{ CATEGORY, LOG2 OP X A C CP,        	LAMBDA(  log2( x + c )          ) },
-		{ CATEGORY, LOG2 OP Y A C CP,        	LAMBDA(  log2( y + c )          ) },
-		{ CATEGORY, LOG10 OP X A C CP,       	LAMBDA(  log10( x + c )         ) },
-		{ CATEGORY, LOG10 OP Y A C CP,       	LAMBDA(  log10( y + c )         ) },
+		{ CATEGORY, LOG OP X A C CP,         	LAMBDA(  ao::log( x + c )           ) }, // Logarithmic
+		{ CATEGORY, LOG OP Y A C CP,         	LAMBDA(  ao::log( y + c )           ) },
+		{ CATEGORY, LOG2 OP X A C CP,        	LAMBDA(  ao::log2( x + c )          ) },
+		{ CATEGORY, LOG2 OP Y A C CP,        	LAMBDA(  ao::log2( y + c )          ) },
+		{ CATEGORY, LOG10 OP X A C CP,       	LAMBDA(  ao::log10( x + c )         ) },
+		{ CATEGORY, LOG10 OP Y A C CP,       	LAMBDA(  ao::log10( y + c )         ) },
 #undef CATEGORY
 #define CATEGORY 14
-		{ CATEGORY, E SX SA SC,              	LAMBDA(  exp( x + c )           ) }, // Exponential
-		{ CATEGORY, E SY SA SC,              	LAMBDA(  exp( y + c )           ) },
-		{ CATEGORY, E SC SX,                 	LAMBDA(  exp( c * x )           ) },
-		{ CATEGORY, E SC SY,                 	LAMBDA(  exp( c * y )           ) },
-		{ CATEGORY, "2" SX SA SC,            	LAMBDA(  powf( 2, x + c )       ) },
-		{ CATEGORY, "2" SY SA SC,            	LAMBDA(  powf( 2, y + c )       ) },
-		{ CATEGORY, "2" SC SX,               	LAMBDA(  powf( 2, c * x )       ) },
-		{ CATEGORY, "2" SC SY,               	LAMBDA(  powf( 2, c * y )       ) },
-		{ CATEGORY, "10" SX SA SC,           	LAMBDA(  powf( 10, x + c )      ) },
-		{ CATEGORY, "10" SY SA SC,           	LAMBDA(  powf( 10, y + c )      ) },
-		{ CATEGORY, "10" SC SX,              	LAMBDA(  powf( 10, c * x )      ) },
-		{ CATEGORY, "10" SC SY,              	LAMBDA(  powf( 10, c * y )      	) },
+		{ CATEGORY, E SX SA SC,              	LAMBDA(  ao::exp( x + c )           ) }, // Exponential
+		{ CATEGORY, E SY SA SC,              	LAMBDA(  ao::exp( y + c )           ) },
+		{ CATEGORY, E SC SX,                 	LAMBDA(  ao::exp( c * x )           ) },
+		{ CATEGORY, E SC SY,                 	LAMBDA(  ao::exp( c * y )           ) },
+		{ CATEGORY, "2" SX SA SC,            	LAMBDA(  ao::pow( 2, x + c )       ) },
+		{ CATEGORY, "2" SY SA SC,            	LAMBDA(  ao::pow( 2, y + c )       ) },
+		{ CATEGORY, "2" SC SX,               	LAMBDA(  ao::pow( 2, c * x )       ) },
+		{ CATEGORY, "2" SC SY,               	LAMBDA(  ao::pow( 2, c * y )       ) },
+		{ CATEGORY, "10" SX SA SC,           	LAMBDA(  ao::pow( 10, x + c )      ) },
+		{ CATEGORY, "10" SY SA SC,           	LAMBDA(  ao::pow( 10, y + c )      ) },
+		{ CATEGORY, "10" SC SX,              	LAMBDA(  ao::pow( 10, c * x )      ) },
+		{ CATEGORY, "10" SC SY,              	LAMBDA(  ao::pow( 10, c * y )      	) },
 #undef CATEGORY
 #define CATEGORY 15
-		{ CATEGORY, IF X G Z T Y H C,	   	LAMBDA(  (x > 0) ? y : c	   ) }, // Conditional X and 0
-		{ CATEGORY, IF X L Z T Y H C,	   	LAMBDA(  (x < 0) ? y : c	   ) },
-		{ CATEGORY, IF X Q Z T Y H C,	   	LAMBDA(  (x == 0) ? y : c	   ) },
-		{ CATEGORY, IF X G Z T C H Y,	   	LAMBDA(  (x > 0) ? c : y	   ) },
-		{ CATEGORY, IF X L Z T C H Y,	   	LAMBDA(  (x < 0) ? c : y	   ) },
-		{ CATEGORY, IF X Q Z T C H Y,	   	LAMBDA(  (x == 0) ? c : y	   ) },
-		{ CATEGORY, IF X G Z T W H Z,	   	LAMBDA(  (x > 0) ? 1 : 0	   ) },
-		{ CATEGORY, IF X L Z T W H Z,	   	LAMBDA(  (x < 0) ? 1 : 0	   ) },
-		{ CATEGORY, IF X Q Z T W H Z,	   	LAMBDA(  (x == 0) ? 1 : 0	   ) },
-		{ CATEGORY, IF X G Z T X H C,	   	LAMBDA(  (x > 0) ? x : c	   ) },
-		{ CATEGORY, IF X L Z T X H C,	   	LAMBDA(  (x < 0) ? x : c	   ) },
-		{ CATEGORY, IF X Q Z T X H C,	   	LAMBDA(  (x == 0) ? x : c	   ) },
-		{ CATEGORY, IF X G Z T C H X,	   	LAMBDA(  (x > 0) ? c : x	   ) },
-		{ CATEGORY, IF X L Z T C H X,	   	LAMBDA(  (x < 0) ? c : x	   ) },
-		{ CATEGORY, IF X Q Z T C H X,	   	LAMBDA(  (x == 0) ? c : x	   ) },
+		{ CATEGORY, IF X G Z T Y H C,	   	LAMBDA(  ao::ifelse( x > 0, y, c )	   ) }, // Conditional X and 0
+		{ CATEGORY, IF X L Z T Y H C,	   	LAMBDA(  ao::ifelse( x < 0, y, c )	   ) },
+		{ CATEGORY, IF X Q Z T Y H C,	   	LAMBDA(  ao::ifelse( x == 0, y, c )	   ) },
+		{ CATEGORY, IF X G Z T C H Y,	   	LAMBDA(  ao::ifelse( x > 0, c, y )	   ) },
+		{ CATEGORY, IF X L Z T C H Y,	   	LAMBDA(  ao::ifelse( x < 0, c, y )	   ) },
+		{ CATEGORY, IF X Q Z T C H Y,	   	LAMBDA(  ao::ifelse( x == 0, c, y )	   ) },
+		{ CATEGORY, IF X G Z T W H Z,	   	LAMBDA(  ao::ifelse( x > 0, 1, 0 )	   ) },
+		{ CATEGORY, IF X L Z T W H Z,	   	LAMBDA(  ao::ifelse( x < 0, 1, 0 )	   ) },
+		{ CATEGORY, IF X Q Z T W H Z,	   	LAMBDA(  ao::ifelse( x == 0, 1, 0 )	   ) },
+		{ CATEGORY, IF X G Z T X H C,	   	LAMBDA(  ao::ifelse( x > 0, x, c )	   ) },
+		{ CATEGORY, IF X L Z T X H C,	   	LAMBDA(  ao::ifelse( x < 0, x, c )	   ) },
+		{ CATEGORY, IF X Q Z T X H C,	   	LAMBDA(  ao::ifelse( x == 0, x, c )	   ) },
+		{ CATEGORY, IF X G Z T C H X,	   	LAMBDA(  ao::ifelse( x > 0, c, x )	   ) },
+		{ CATEGORY, IF X L Z T C H X,	   	LAMBDA(  ao::ifelse( x < 0, c, x )	   ) },
+		{ CATEGORY, IF X Q Z T C H X,	   	LAMBDA(  ao::ifelse( x == 0, c, x )	   ) },
 #undef CATEGORY
 #define CATEGORY 16
-		{ CATEGORY, IF Y G Z T X H C,	   	LAMBDA(  (y > 0) ? x : c	   ) }, // Conditional Y and 0
-		{ CATEGORY, IF Y L Z T X H C,	   	LAMBDA(  (y < 0) ? x : c	   ) },
-		{ CATEGORY, IF Y Q Z T X H C,	   	LAMBDA(  (y == 0) ? x : c	   ) },
-		{ CATEGORY, IF Y G Z T C H X,	   	LAMBDA(  (y > 0) ? c : x	   ) },
-		{ CATEGORY, IF Y L Z T C H X,	   	LAMBDA(  (y < 0) ? c : x	   ) },
-		{ CATEGORY, IF Y Q Z T C H X,	   	LAMBDA(  (y == 0) ? c : x	   ) },
-		{ CATEGORY, IF Y G Z T W H Z,	   	LAMBDA(  (y > 0) ? 1 : 0	   ) },
-		{ CATEGORY, IF Y L Z T W H Z,	   	LAMBDA(  (y < 0) ? 1 : 0	   ) },
-		{ CATEGORY, IF Y Q Z T W H Z,	   	LAMBDA(  (y == 0) ? 1 : 0	   ) },
-		{ CATEGORY, IF Y G Z T Y H C,	   	LAMBDA(  (y > 0) ? y : c	   ) },
-		{ CATEGORY, IF Y L Z T Y H C,	   	LAMBDA(  (y < 0) ? y : c	   ) },
-		{ CATEGORY, IF Y Q Z T Y H C,	   	LAMBDA(  (y == 0) ? y : c	   ) },
-		{ CATEGORY, IF Y G Z T C H Y,	   	LAMBDA(  (y > 0) ? c : y	   ) },
-		{ CATEGORY, IF Y L Z T C H Y,	   	LAMBDA(  (y < 0) ? c : y	   ) },
-		{ CATEGORY, IF Y Q Z T C H Y,	   	LAMBDA(  (y == 0) ? c : y	   ) },
+		{ CATEGORY, IF Y G Z T X H C,	   	LAMBDA(  ao::ifelse( y > 0, x, c )	   ) }, // Conditional Y and 0
+		{ CATEGORY, IF Y L Z T X H C,	   	LAMBDA(  ao::ifelse( y < 0, x, c )	   ) },
+		{ CATEGORY, IF Y Q Z T X H C,	   	LAMBDA(  ao::ifelse( y == 0, x, c )	   ) },
+		{ CATEGORY, IF Y G Z T C H X,	   	LAMBDA(  ao::ifelse( y > 0, c, x )	   ) },
+		{ CATEGORY, IF Y L Z T C H X,	   	LAMBDA(  ao::ifelse( y < 0, c, x )	   ) },
+		{ CATEGORY, IF Y Q Z T C H X,	   	LAMBDA(  ao::ifelse( y == 0, c, x )	   ) },
+		{ CATEGORY, IF Y G Z T W H Z,	   	LAMBDA(  ao::ifelse( y > 0, 1, 0 )	   ) },
+		{ CATEGORY, IF Y L Z T W H Z,	   	LAMBDA(  ao::ifelse( y < 0, 1, 0 )	   ) },
+		{ CATEGORY, IF Y Q Z T W H Z,	   	LAMBDA(  ao::ifelse( y == 0, 1, 0 )	   ) },
+		{ CATEGORY, IF Y G Z T Y H C,	   	LAMBDA(  ao::ifelse( y > 0, y, c )	   ) },
+		{ CATEGORY, IF Y L Z T Y H C,	   	LAMBDA(  ao::ifelse( y < 0, y, c )	   ) },
+		{ CATEGORY, IF Y Q Z T Y H C,	   	LAMBDA(  ao::ifelse( y == 0, y, c )	   ) },
+		{ CATEGORY, IF Y G Z T C H Y,	   	LAMBDA(  ao::ifelse( y > 0, c, y )	   ) },
+		{ CATEGORY, IF Y L Z T C H Y,	   	LAMBDA(  ao::ifelse( y < 0, c, y )	   ) },
+		{ CATEGORY, IF Y Q Z T C H Y,	   	LAMBDA(  ao::ifelse( y == 0, c, y )	   ) },
 #undef CATEGORY
 #define CATEGORY 17
-		{ CATEGORY, IF X G Y T C H Z,	   	LAMBDA(  (x > y) ? c : 0	   ) }, // Conditional X and Y
-		{ CATEGORY, IF X L Y T C H Z,        	LAMBDA(  (x < y) ? c : 0	   ) },
-		{ CATEGORY, IF X Q Y T C H Z,	   	LAMBDA(  (x == y) ? c : 0	   ) },
-		{ CATEGORY, IF Y G X T C H Z,	   	LAMBDA(  (y > x) ? c : 0	   ) },
-		{ CATEGORY, IF Y L X T C H Z,        	LAMBDA(  (y < x) ? c : 0	   ) },
-		{ CATEGORY, IF X G Y T X H Z,	   	LAMBDA(  (x > y) ? x : 0	   ) },
-		{ CATEGORY, IF X L Y T X H Z,        	LAMBDA(  (x < y) ? x : 0	   ) },
-		{ CATEGORY, IF X Q Y T X H Z,	   	LAMBDA(  (x == y) ? x : 0	   ) },
-		{ CATEGORY, IF Y G X T X H Z,	   	LAMBDA(  (y > x) ? x : 0	   ) },
-		{ CATEGORY, IF Y L X T X H Z,        	LAMBDA(  (y < x) ? x : 0	   ) },
-		{ CATEGORY, IF X G Y T Y H Z,	   	LAMBDA(  (x > y) ? y : 0	   ) },
-		{ CATEGORY, IF X L Y T Y H Z,        	LAMBDA(  (x < y) ? y : 0	   ) },
-		{ CATEGORY, IF X Q Y T Y H Z,	   	LAMBDA(  (x == y) ? y : 0	   ) },
-		{ CATEGORY, IF Y G X T Y H Z,	   	LAMBDA(  (y > x) ? y : 0	   ) },
-		{ CATEGORY, IF Y L X T Y H Z,        	LAMBDA(  (y < x) ? y : 0	   ) },
+		{ CATEGORY, IF X G Y T C H Z,	   	LAMBDA(  ao::ifelse( x > y, c, 0 )	   ) }, // Conditional X and Y
+		{ CATEGORY, IF X L Y T C H Z,        	LAMBDA(  ao::ifelse( x < y, c, 0 )	   ) },
+		{ CATEGORY, IF X Q Y T C H Z,	   	LAMBDA(  ao::ifelse( x == y, c, 0 )	   ) },
+		{ CATEGORY, IF Y G X T C H Z,	   	LAMBDA(  ao::ifelse( y > x, c, 0 )	   ) },
+		{ CATEGORY, IF Y L X T C H Z,        	LAMBDA(  ao::ifelse( y < x, c, 0 )	   ) },
+		{ CATEGORY, IF X G Y T X H Z,	   	LAMBDA(  ao::ifelse( x > y, x, 0 )	   ) },
+		{ CATEGORY, IF X L Y T X H Z,        	LAMBDA(  ao::ifelse( x < y, x, 0 )	   ) },
+		{ CATEGORY, IF X Q Y T X H Z,	   	LAMBDA(  ao::ifelse( x == y, x, 0 )	   ) },
+		{ CATEGORY, IF Y G X T X H Z,	   	LAMBDA(  ao::ifelse( y > x, x, 0 )	   ) },
+		{ CATEGORY, IF Y L X T X H Z,        	LAMBDA(  ao::ifelse( y < x, x, 0 )	   ) },
+		{ CATEGORY, IF X G Y T Y H Z,	   	LAMBDA(  ao::ifelse( x > y, y, 0 )	   ) },
+		{ CATEGORY, IF X L Y T Y H Z,        	LAMBDA(  ao::ifelse( x < y, y, 0 )	   ) },
+		{ CATEGORY, IF X Q Y T Y H Z,	   	LAMBDA(  ao::ifelse( x == y, y, 0 )	   ) },
+		{ CATEGORY, IF Y G X T Y H Z,	   	LAMBDA(  ao::ifelse( y > x, y, 0 )	   ) },
+		{ CATEGORY, IF Y L X T Y H Z,        	LAMBDA(  ao::ifelse( y < x, y, 0 )	   ) },
 #undef CATEGORY
 #define CATEGORY 18
-		{ CATEGORY, IF X G C T Y H Z,	   	LAMBDA(  (x > c) ? y : 0	   ) }, // Conditional X and C
-		{ CATEGORY, IF X L C T Y H Z,        	LAMBDA(  (x < c) ? y : 0	   ) },
-		{ CATEGORY, IF X Q C T Y H Z,	   	LAMBDA(  (x == c) ? y : 0	   ) },
-		{ CATEGORY, IF C G X T Y H Z,	   	LAMBDA(  (c > x) ? y : 0	   ) },
-		{ CATEGORY, IF C L X T Y H Z,        	LAMBDA(  (c < x) ? y : 0	   ) },
-		{ CATEGORY, IF X G C T X H Z,	   	LAMBDA(  (x > c) ? x : 0	   ) },
-		{ CATEGORY, IF X L C T X H Z,        	LAMBDA(  (x < c) ? x : 0	   ) },
-		{ CATEGORY, IF X Q C T X H Z,	   	LAMBDA(  (x == c) ? x : 0	   ) },
-		{ CATEGORY, IF C G X T X H Z,	   	LAMBDA(  (c > x) ? x : 0	   ) },
-		{ CATEGORY, IF C L X T X H Z,        	LAMBDA(  (c < x) ? x : 0	   ) },
-		{ CATEGORY, IF X G C T X H Y,	   	LAMBDA(  (x > c) ? x : y	   ) },
-		{ CATEGORY, IF X L C T X H Y,        	LAMBDA(  (x < c) ? x : y	   ) },
-		{ CATEGORY, IF X Q C T X H Y,	   	LAMBDA(  (x == c) ? x : y	   ) },
-		{ CATEGORY, IF C G X T X H Y,	   	LAMBDA(  (c > x) ? x : y	   ) },
-		{ CATEGORY, IF C L X T X H Y,        	LAMBDA(  (c < x) ? x : y	   ) },
+		{ CATEGORY, IF X G C T Y H Z,	   	LAMBDA(  ao::ifelse( x > c, y, 0 )	   ) }, // Conditional X and C
+		{ CATEGORY, IF X L C T Y H Z,        	LAMBDA(  ao::ifelse( x < c, y, 0 )	   ) },
+		{ CATEGORY, IF X Q C T Y H Z,	   	LAMBDA(  ao::ifelse( x == c, y, 0 )	   ) },
+		{ CATEGORY, IF C G X T Y H Z,	   	LAMBDA(  ao::ifelse( c > x, y, 0 )	   ) },
+		{ CATEGORY, IF C L X T Y H Z,        	LAMBDA(  ao::ifelse( c < x, y, 0 )	   ) },
+		{ CATEGORY, IF X G C T X H Z,	   	LAMBDA(  ao::ifelse( x > c, x, 0 )	   ) },
+		{ CATEGORY, IF X L C T X H Z,        	LAMBDA(  ao::ifelse( x < c, x, 0 )	   ) },
+		{ CATEGORY, IF X Q C T X H Z,	   	LAMBDA(  ao::ifelse( x == c, x, 0 )	   ) },
+		{ CATEGORY, IF C G X T X H Z,	   	LAMBDA(  ao::ifelse( c > x, x, 0 )	   ) },
+		{ CATEGORY, IF C L X T X H Z,        	LAMBDA(  ao::ifelse( c < x, x, 0 )	   ) },
+		{ CATEGORY, IF X G C T X H Y,	   	LAMBDA(  ao::ifelse( x > c, x, y )	   ) },
+		{ CATEGORY, IF X L C T X H Y,        	LAMBDA(  ao::ifelse( x < c, x, y )	   ) },
+		{ CATEGORY, IF X Q C T X H Y,	   	LAMBDA(  ao::ifelse( x == c, x, y )	   ) },
+		{ CATEGORY, IF C G X T X H Y,	   	LAMBDA(  ao::ifelse( c > x, x, y )	   ) },
+		{ CATEGORY, IF C L X T X H Y,        	LAMBDA(  ao::ifelse( c < x, x, y )	   ) },
 #undef CATEGORY
 #define CATEGORY 19
-		{ CATEGORY, IF Y G C T X H Z,	   	LAMBDA(  (y > c) ? x : 0	   ) },	// Conditional Y and C
-		{ CATEGORY, IF Y L C T X H Z,        	LAMBDA(  (y < c) ? x : 0	   ) },
-		{ CATEGORY, IF Y Q C T X H Z,	   	LAMBDA(  (y == c) ? x : 0	   ) },
-		{ CATEGORY, IF C G Y T X H Z,	   	LAMBDA(  (c > y) ? x : 0	   ) },
-		{ CATEGORY, IF C L Y T X H Z,        	LAMBDA(  (c < y) ? x : 0	   ) },
-		{ CATEGORY, IF Y G C T Y H Z,	   	LAMBDA(  (y > c) ? y : 0	   ) },
-		{ CATEGORY, IF Y L C T Y H Z,        	LAMBDA(  (y < c) ? y : 0	   ) },
-		{ CATEGORY, IF Y Q C T Y H Z,	   	LAMBDA(  (y == c) ? y : 0	   ) },
-		{ CATEGORY, IF C G Y T Y H Z,	   	LAMBDA(  (c > y) ? y : 0	   ) },
-		{ CATEGORY, IF C L Y T Y H Z,        	LAMBDA(  (c < y) ? y : 0	   ) },
-		{ CATEGORY, IF Y G C T Y H X,	   	LAMBDA(  (y > c) ? y : x	   ) },
-		{ CATEGORY, IF Y L C T Y H X,        	LAMBDA(  (y < c) ? y : x	   ) },
-		{ CATEGORY, IF Y Q C T Y H X,	   	LAMBDA(  (y == c) ? y : x	   ) },
-		{ CATEGORY, IF C G Y T Y H X,	   	LAMBDA(  (c > y) ? y : x	   ) },
-		{ CATEGORY, IF C L Y T Y H X,        	LAMBDA(  (c < y) ? y : x	   ) },
+		{ CATEGORY, IF Y G C T X H Z,	   	LAMBDA(  ao::ifelse( y > c, x, 0 )	   ) },	// Conditional Y and C
+		{ CATEGORY, IF Y L C T X H Z,        	LAMBDA(  ao::ifelse( y < c, x, 0 )	   ) },
+		{ CATEGORY, IF Y Q C T X H Z,	   	LAMBDA(  ao::ifelse( y == c, x, 0 )	   ) },
+		{ CATEGORY, IF C G Y T X H Z,	   	LAMBDA(  ao::ifelse( c > y, x, 0 )	   ) },
+		{ CATEGORY, IF C L Y T X H Z,        	LAMBDA(  ao::ifelse( c < y, x, 0 )	   ) },
+		{ CATEGORY, IF Y G C T Y H Z,	   	LAMBDA(  ao::ifelse( y > c, y, 0 )	   ) },
+		{ CATEGORY, IF Y L C T Y H Z,        	LAMBDA(  ao::ifelse( y < c, y, 0 )	   ) },
+		{ CATEGORY, IF Y Q C T Y H Z,	   	LAMBDA(  ao::ifelse( y == c, y, 0 )	   ) },
+		{ CATEGORY, IF C G Y T Y H Z,	   	LAMBDA(  ao::ifelse( c > y, y, 0 )	   ) },
+		{ CATEGORY, IF C L Y T Y H Z,        	LAMBDA(  ao::ifelse( c < y, y, 0 )	   ) },
+		{ CATEGORY, IF Y G C T Y H X,	   	LAMBDA(  ao::ifelse( y > c, y, x )	   ) },
+		{ CATEGORY, IF Y L C T Y H X,        	LAMBDA(  ao::ifelse( y < c, y, x )	   ) },
+		{ CATEGORY, IF Y Q C T Y H X,	   	LAMBDA(  ao::ifelse( y == c, y, x )	   ) },
+		{ CATEGORY, IF C G Y T Y H X,	   	LAMBDA(  ao::ifelse( c > y, y, x )	   ) },
+		{ CATEGORY, IF C L Y T Y H X,        	LAMBDA(  ao::ifelse( c < y, y, x )	   ) },
+#undef CATEGORY
+#define CATEGORY 20
+		{ CATEGORY, F OP X COMMA Y COMMA C CP,	LAMBDA(  0                      ) }, // Expression
+#undef CATEGORY
 
 	};	
 
@@ -375,8 +562,536 @@ namespace {
 #undef F
 #undef LAM
 
+	// The expression entry is always the last in the table, so the indices of the fixed
+	// algorithms are unchanged.
+	unsigned int expressionFunction = functions.size() - 1;
+
+	// A free-form expression, compiled once into a short register program. Registers 0, 1 
+	// and 2 hold X, Y and C, followed by the constants and then the temporary values.
+	struct Expression {
+		enum Opcode {
+			OP_ADD,
+			OP_SUB,
+			OP_MUL,
+			OP_DIV,
+			OP_MOD,
+			OP_POW,
+			OP_NEG,
+			OP_LT,
+			OP_GT,
+			OP_LE,
+			OP_GE,
+			OP_EQ,
+			OP_NE,
+			OP_IF,
+			OP_MIN,
+			OP_MAX,
+			OP_ABS,
+			OP_SQRT,
+			OP_SIN,
+			OP_COS,
+			OP_TAN,
+			OP_ASIN,
+			OP_ACOS,
+			OP_ATAN,
+			OP_LOG,
+			OP_LOG2,
+			OP_LOG10,
+			OP_EXP,
+			NUM_OPS
+		};
+		static const unsigned int MAX_REGISTERS = 32;
+		static const unsigned int MAX_INSTRUCTIONS = 64;
+		struct Instruction {
+			uint8_t op;
+			uint8_t dst;
+			uint8_t a;
+			uint8_t b;
+			uint8_t c;
+		};
+		Instruction code[MAX_INSTRUCTIONS];
+		float constants[MAX_REGISTERS];
+		unsigned int length;
+		unsigned int constantEnd;
+		unsigned int result;
+
+		Expression() {
+			clear();
+		}
+		// An empty or invalid expression always evaluates to 0
+		void clear() {
+			length = 0;
+			constants[3] = 0.0f;
+			constantEnd = 4;
+			result = 3;
+		}
+		template <typename M, typename T>
+		static T apply(unsigned int op, T a, T b, T c) {
+			switch (op) {
+				case OP_ADD:	return a + b;
+				case OP_SUB:	return a - b;
+				case OP_MUL:	return a * b;
+				case OP_DIV:	return a / b;
+				case OP_MOD:	return M::fmod(a, b);
+				case OP_POW:	return M::pow(a, b);
+				case OP_NEG:	return 0.0f - a;
+				case OP_LT:	return M::truth(a < b);
+				case OP_GT:	return M::truth(a > b);
+				case OP_LE:	return M::truth(a <= b);
+				case OP_GE:	return M::truth(a >= b);
+				case OP_EQ:	return M::truth(a == b);
+				case OP_NE:	return M::truth(a != b);
+				case OP_IF:	return M::ifelse(a != 0.0f, b, c);
+				case OP_MIN:	return M::min(a, b);
+				case OP_MAX:	return M::max(a, b);
+				case OP_ABS:	return M::abs(a);
+				case OP_SQRT:	return M::sqrt(a);
+				case OP_SIN:	return M::sin(a);
+				case OP_COS:	return M::cos(a);
+				case OP_TAN:	return M::tan(a);
+				case OP_ASIN:	return M::asin(a);
+				case OP_ACOS:	return M::acos(a);
+				case OP_ATAN:	return M::atan(a);
+				case OP_LOG:	return M::log(a);
+				case OP_LOG2:	return M::log2(a);
+				case OP_LOG10:	return M::log10(a);
+				case OP_EXP:	return M::exp(a);
+			}
+			return 0.0f;
+		}
+		template <typename M, typename T>
+		T run(T x, T y, T c) const {
+			T r[MAX_REGISTERS];
+			r[0] = x;
+			r[1] = y;
+			r[2] = c;
+			for (unsigned int i = 3; i < constantEnd; i++) {
+				r[i] = constants[i];
+			}
+			for (const Instruction *in = code, *end = code + length; in < end; in++) {
+				r[in->dst] = apply<M>(in->op, r[in->a], r[in->b], r[in->c]);
+			}
+			return r[result];
+		}
+		std::string compile(const std::string &text);
+	};
+
+	// Recursive descent parser for expressions such as "sin(x * 2) + y / c".
+	// Any operation whose arguments are all constant is folded as it is parsed.
+	struct ExpressionCompiler {
+		enum NodeType {
+			NODE_CONST = Expression::NUM_OPS,
+			NODE_VAR
+		};
+		struct Node {
+			unsigned int op;
+			float value = 0.0f;
+			unsigned int reg = 0;
+			std::unique_ptr<Node> args[3];
+		};
+		typedef std::unique_ptr<Node> NodePtr;
+
+		struct Builtin {
+			const char *name;
+			unsigned int op;
+			unsigned int args;
+		};
+
+		const char *p;
+		std::string error;
+		Expression *expression;
+		unsigned int next;
+
+		static unsigned int arity(unsigned int op) {
+			switch (op) {
+				case Expression::OP_IF:
+					return 3;
+				case Expression::OP_NEG:
+				case Expression::OP_ABS:
+				case Expression::OP_SQRT:
+				case Expression::OP_SIN:
+				case Expression::OP_COS:
+				case Expression::OP_TAN:
+				case Expression::OP_ASIN:
+				case Expression::OP_ACOS:
+				case Expression::OP_ATAN:
+				case Expression::OP_LOG:
+				case Expression::OP_LOG2:
+				case Expression::OP_LOG10:
+				case Expression::OP_EXP:
+					return 1;
+			}
+			return 2;
+		}
+
+		NodePtr fail(std::string message) {
+			if (error.empty())
+				error = message;
+			return NodePtr();
+		}
+
+		void skip() {
+			while (*p == ' ' || *p == '\t')
+				p++;
+		}
+
+		bool accept(const char *token) {
+			skip();
+			size_t len = strlen(token);
+			if (strncmp(p, token, len))
+				return false;
+			p += len;
+			return true;
+		}
+
+		NodePtr leaf(unsigned int type, float value, unsigned int reg) {
+			NodePtr node(new Node());
+			node->op = type;
+			node->value = value;
+			node->reg = reg;
+			return node;
+		}
+
+		NodePtr makeNode(unsigned int op, NodePtr a, NodePtr b = NodePtr(), NodePtr c = NodePtr()) {
+			bool folds = (a->op == NODE_CONST) && (!b || b->op == NODE_CONST) && (!c || c->op == NODE_CONST);
+			if (folds) {
+				return leaf(NODE_CONST, Expression::apply<AOMath, float>(op, a->value, b ? b->value : 0.0f, c ? c->value : 0.0f), 0);
+			}
+			NodePtr node(new Node());
+			node->op = op;
+			node->args[0] = std::move(a);
+			node->args[1] = std::move(b);
+			node->args[2] = std::move(c);
+			return node;
+		}
+
+		NodePtr parseExpression() {
+			NodePtr cond = parseComparison();
+			if (!cond || !accept("?"))
+				return cond;
+			NodePtr a = parseExpression();
+			if (!a)
+				return a;
+			if (!accept(":"))
+				return fail("Expected :");
+			NodePtr b = parseExpression();
+			if (!b)
+				return b;
+			return makeNode(Expression::OP_IF, std::move(cond), std::move(a), std::move(b));
+		}
+
+		NodePtr parseComparison() {
+			NodePtr a = parseSum();
+			if (!a)
+				return a;
+			unsigned int op;
+			if (accept("<="))
+				op = Expression::OP_LE;
+			else if (accept(">="))
+				op = Expression::OP_GE;
+			else if (accept("=="))
+				op = Expression::OP_EQ;
+			else if (accept("!="))
+				op = Expression::OP_NE;
+			else if (accept("<"))
+				op = Expression::OP_LT;
+			else if (accept(">"))
+				op = Expression::OP_GT;
+			else if (accept("="))
+				op = Expression::OP_EQ;
+			else
+				return a;
+			NodePtr b = parseSum();
+			if (!b)
+				return b;
+			return makeNode(op, std::move(a), std::move(b));
+		}
+
+		NodePtr parseSum() {
+			NodePtr a = parseProduct();
+			while (a) {
+				unsigned int op;
+				if (accept("+"))
+					op = Expression::OP_ADD;
+				else if (accept("-"))
+					op = Expression::OP_SUB;
+				else
+					break;
+				NodePtr b = parseProduct();
+				if (!b)
+					return b;
+				a = makeNode(op, std::move(a), std::move(b));
+			}
+			return a;
+		}
+
+		NodePtr parseProduct() {
+			NodePtr a = parseUnary();
+			while (a) {
+				unsigned int op;
+				if (accept("*"))
+					op = Expression::OP_MUL;
+				else if (accept("/"))
+					op = Expression::OP_DIV;
+				else if (accept("%"))
+					op = Expression::OP_MOD;
+				else
+					break;
+				NodePtr b = parseUnary();
+				if (!b)
+					return b;
+				a = makeNode(op, std::move(a), std::move(b));
+			}
+			return a;
+		}
+
+		NodePtr parseUnary() {
+			if (accept("-")) {
+				NodePtr a = parseUnary();
+				if (!a)
+					return a;
+				return makeNode(Expression::OP_NEG, std::move(a));
+			}
+			if (accept("+"))
+				return parseUnary();
+			return parsePower();
+		}
+
+		NodePtr parsePower() {
+			NodePtr a = parsePrimary();
+			if (!a || !accept("^"))
+				return a;
+			NodePtr b = parseUnary();
+			if (!b)
+				return b;
+			return makeNode(Expression::OP_POW, std::move(a), std::move(b));
+		}
+
+		NodePtr parsePrimary() {
+			static const Builtin builtins[] = {
+				{ "if",		Expression::OP_IF,	3 },
+				{ "min",	Expression::OP_MIN,	2 },
+				{ "max",	Expression::OP_MAX,	2 },
+				{ "pow",	Expression::OP_POW,	2 },
+				{ "mod",	Expression::OP_MOD,	2 },
+				{ "abs",	Expression::OP_ABS,	1 },
+				{ "sqrt",	Expression::OP_SQRT,	1 },
+				{ "sin",	Expression::OP_SIN,	1 },
+				{ "cos",	Expression::OP_COS,	1 },
+				{ "tan",	Expression::OP_TAN,	1 },
+				{ "asin",	Expression::OP_ASIN,	1 },
+				{ "acos",	Expression::OP_ACOS,	1 },
+				{ "atan",	Expression::OP_ATAN,	1 },
+				{ "log",	Expression::OP_LOG,	1 },
+				{ "log2",	Expression::OP_LOG2,	1 },
+				{ "log10",	Expression::OP_LOG10,	1 },
+				{ "exp",	Expression::OP_EXP,	1 }
+			};
+			skip();
+			if (isdigit((unsigned char)*p) || *p == '.') {
+				char *end;
+				float value = strtof(p, &end);
+				if (end == p)
+					return fail("Invalid number");
+				p = end;
+				return leaf(NODE_CONST, value, 0);
+			}
+			if (isalpha((unsigned char)*p)) {
+				std::string name;
+				while (isalnum((unsigned char)*p) || *p == '_')
+					name.push_back(tolower((unsigned char)*p++));
+				if (name == "x")
+					return leaf(NODE_VAR, 0.0f, 0);
+				if (name == "y")
+					return leaf(NODE_VAR, 0.0f, 1);
+				if (name == "c")
+					return leaf(NODE_VAR, 0.0f, 2);
+				if (name == "pi")
+					return leaf(NODE_CONST, M_PI, 0);
+				if (name == "tau")
+					return leaf(NODE_CONST, 2 * M_PI, 0);
+				if (name == "e")
+					return leaf(NODE_CONST, M_E, 0);
+				for (const Builtin &builtin : builtins) {
+					if (name != builtin.name)
+						continue;
+					if (!accept("("))
+						return fail("Expected ( after " + name);
+					NodePtr args[3];
+					for (unsigned int i = 0; i < builtin.args; i++) {
+						if (i && !accept(","))
+							return fail("Expected , in " + name);
+						args[i] = parseExpression();
+						if (!args[i])
+							return NodePtr();
+					}
+					if (!accept(")"))
+						return fail("Expected ) after " + name);
+					return makeNode(builtin.op, std::move(args[0]), std::move(args[1]), std::move(args[2]));
+				}
+				return fail("Unknown name " + name);
+			}
+			if (accept("(")) {
+				NodePtr a = parseExpression();
+				if (!a)
+					return a;
+				if (!accept(")"))
+					return fail("Expected )");
+				return a;
+			}
+			return fail(*p ? std::string("Unexpected ") + *p : "Unexpected end");
+		}
+
+		void allocateConstants(Node *node) {
+			if (!node)
+				return;
+			if (node->op == NODE_CONST) {
+				for (unsigned int i = 3; i < expression->constantEnd; i++) {
+					if (expression->constants[i] == node->value) {
+						node->reg = i;
+						return;
+					}
+				}
+				if (expression->constantEnd >= Expression::MAX_REGISTERS) {
+					fail("Too many constants");
+					return;
+				}
+				node->reg = expression->constantEnd++;
+				expression->constants[node->reg] = node->value;
+				return;
+			}
+			for (unsigned int i = 0; i < 3; i++) {
+				allocateConstants(node->args[i].get());
+			}
+		}
+
+		// Temporary registers are used like a stack, so the arguments of an instruction
+		// are free for reuse as soon as it has been emitted.
+		unsigned int emit(Node *node) {
+			if (node->op == NODE_CONST || node->op == NODE_VAR)
+				return node->reg;
+			unsigned int mark = next;
+			unsigned int regs[3] = { 0, 0, 0 };
+			for (unsigned int i = 0; i < arity(node->op); i++) {
+				regs[i] = emit(node->args[i].get());
+			}
+			next = mark;
+			unsigned int dst = next++;
+			if (next > Expression::MAX_REGISTERS) {
+				fail("Expression too complex");
+				return 0;
+			}
+			if (expression->length >= Expression::MAX_INSTRUCTIONS) {
+				fail("Expression too long");
+				return 0;
+			}
+			Expression::Instruction &in = expression->code[expression->length++];
+			in.op = node->op;
+			in.dst = dst;
+			in.a = regs[0];
+			in.b = regs[1];
+			in.c = regs[2];
+			return dst;
+		}
+
+		std::string compile(const std::string &text, Expression *expr) {
+			expression = expr;
+			expression->clear();
+			p = text.c_str();
+			skip();
+			if (!*p)
+				return error;
+			NodePtr root = parseExpression();
+			skip();
+			if (root && *p)
+				fail(std::string("Unexpected ") + *p);
+			if (!error.empty())
+				return error;
+			expression->constantEnd = 3;
+			allocateConstants(root.get());
+			next = expression->constantEnd;
+			if (error.empty())
+				expression->result = emit(root.get());
+			if (!error.empty())
+				expression->clear();
+			return error;
+		}
+	};
+
+	std::string Expression::compile(const std::string &text) {
+		ExpressionCompiler compiler;
+		return compiler.compile(text, this);
+	}
+
+	// Expressions are compiled on the UI thread and handed over to the engine, which only 
+	// ever tries the lock, so process() can never be blocked by an edit.
+	struct AOModule : Module {
+		std::vector<std::string> expressionText;
+		std::vector<std::string> expressionError;
+		std::vector<Expression> expressions;
+		std::vector<Expression> pendingExpressions;
+		bool expressionsChanged = false;
+		std::mutex expressionMutex;
+
+		AOModule(unsigned int cells) : expressionText(cells), expressionError(cells), expressions(cells), pendingExpressions(cells) {}
+
+		void setExpression(unsigned int index, std::string text) {
+			std::lock_guard<std::mutex> lock(expressionMutex);
+			expressionText[index] = text;
+			expressionError[index] = pendingExpressions[index].compile(text);
+			expressionsChanged = true;
+		}
+
+		// Called from the engine; the vectors are the same size, so the copy doesn't allocate
+		bool updateExpressions() {
+			if (!expressionMutex.try_lock())
+				return false;
+			bool changed = expressionsChanged;
+			if (changed) {
+				expressions = pendingExpressions;
+				expressionsChanged = false;
+			}
+			expressionMutex.unlock();
+			return changed;
+		}
+
+		void onReset() override {
+			Module::onReset();
+			for (unsigned int i = 0; i < expressionText.size(); i++) {
+				setExpression(i, "");
+			}
+		}
+
+		json_t *dataToJson() override {
+			json_t *rootJ = json_object();
+			json_t *arr = json_array();
+			std::lock_guard<std::mutex> lock(expressionMutex);
+			for (std::string &text : expressionText) {
+				json_array_append_new(arr, json_string(text.c_str()));
+			}
+			json_object_set_new(rootJ, "expressions", arr);
+			return rootJ;
+		}
+
+		void dataFromJson(json_t *rootJ) override {
+			json_t *arr = json_object_get(rootJ, "expressions");
+			if (arr) {
+				unsigned int size = json_array_size(arr);
+				if (size > expressionText.size())
+					size = expressionText.size();
+				for (unsigned int i = 0; i < size; i++) {
+					json_t *j1 = json_array_get(arr, i);
+					if (json_is_string(j1)) {
+						setExpression(i, json_string_value(j1));
+					}
+				}
+			}
+		}
+	};
+
+#ifndef SUBMARINE_HEADLESS
 	struct AOKnob : Knob {
-		Module *module;
+		AOModule *module;
 		int index;
 	};
 
@@ -404,11 +1119,23 @@ namespace {
 
 	void AOFuncLight::draw(const DrawArgs &args) {
 		if (knob->module) {
+			unsigned int f = APP->engine->getParam(knob->module, knob->index);
+			std::string text = functions[f].name;
+			NVGcolor color = SUBLIGHTBLUE;
+			if (f == expressionFunction) {
+				if (!knob->module->expressionText[knob->index].empty()) {
+					text = knob->module->expressionText[knob->index];
+					if (text.size() > 10)
+						text = text.substr(0, 9) + "\xe2\x80\xa6";
+				}
+				if (!knob->module->expressionError[knob->index].empty())
+					color = SUBLIGHTRED;
+			}
 			nvgFontSize(args.vg, 16);
 			nvgFontFaceId(args.vg, gScheme.font()->handle);
-			nvgFillColor(args.vg, SUBLIGHTBLUE);
+			nvgFillColor(args.vg, color);
 			nvgTextAlign(args.vg, NVG_ALIGN_CENTER);
-			nvgText(args.vg, 41.5, 13, functions[APP->engine->getParam(knob->module, knob->index)].name.c_str(), NULL);
+			nvgText(args.vg, 41.5, 13, text.c_str(), NULL);
 		}
 	}
 
@@ -443,15 +1170,18 @@ namespace {
 			nvgText(args.vg, 41.5, 13, mtext, NULL);
 		}
 	}
+#endif
 
 } // end namespace
 
 template <unsigned int x, unsigned int y>
-struct AO1 : Module {
+struct AO1 : AOModule {
 	enum ParamIds {
 		PARAM_FUNC_1,
 		PARAM_CONST_1 = x * y,
-		NUM_PARAMS = 2 * x * y
+		PARAM_POLY = 2 * x * y,
+		PARAM_FAST,
+		NUM_PARAMS
 	};
 	enum InputIds {
 		INPUT_X_1,
@@ -467,7 +1197,22 @@ struct AO1 : Module {
 		NUM_LIGHTS
 	};
 
-	AO1() : Module() {
+	// The grid is compiled into a list of the cells which are not pass-through, with their
+	// constants already decoded and the precise or fast kernels already chosen. It is only 
+	// rebuilt when a parameter changes.
+	struct Cell {
+		func_t func;
+		func4_t func4;
+		const Expression *expression;
+		float c;
+		unsigned int ix;
+	};
+	Cell cells[x * y];
+	unsigned int rowEnd[y];
+	float compiledParams[NUM_PARAMS];
+	dsp::ClockDivider compileDivider;
+
+	AO1() : AOModule(x * y) {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 		for (unsigned int ix = 0; ix < x; ix++) {
 			for (unsigned int iy = 0; iy < y; iy++) {
@@ -475,30 +1220,121 @@ struct AO1 : Module {
 				configParam(PARAM_CONST_1 + ix + iy * x, -10000.0f, 10000.0f, 0.0f, "Constant", "", 0.f, 0.01f);
 			}
 		}
+		configParam(PARAM_POLY, 0.0f, 1.0f, 0.0f, "Polyphonic");
+		configParam(PARAM_FAST, 0.0f, 1.0f, 0.0f, "Fast Math");
+		compileDivider.setDivision(32);
+		compile();
+	}
+	bool isCompiled() {
+		for (unsigned int i = 0; i < NUM_PARAMS; i++) {
+			if (params[i].getValue() != compiledParams[i])
+				return false;
+		}
+		return true;
+	}
+	void compile() {
+		for (unsigned int i = 0; i < NUM_PARAMS; i++) {
+			compiledParams[i] = params[i].getValue();
+		}
+		bool fast = compiledParams[PARAM_FAST];
+		unsigned int n = 0;
+		for (unsigned int iy = 0; iy < y; iy++) {
+			for (unsigned int ix = 0; ix < x; ix++) {
+				unsigned int f = compiledParams[PARAM_FUNC_1 + ix + iy * x];
+				if (f >= functions.size())
+					f = functions.size() - 1;
+				// if f is equal to 0, then both x and y pass (crossing) through the cell unchanged,
+				// so it doesn't need to be in the compiled list at all.
+				if (f > 0) {
+					cells[n].func = fast?functions[f].fastFunc:functions[f].func;
+					cells[n].func4 = fast?functions[f].fastFunc4:functions[f].func4;
+					cells[n].expression = (f == expressionFunction)?&expressions[ix + iy * x]:NULL;
+					cells[n].c = ((int)compiledParams[PARAM_CONST_1 + ix + iy * x])/100.0f;
+					cells[n].ix = ix;
+					n++;
+				}
+			}
+			rowEnd[iy] = n;
+		}
 	}
 	void process(const ProcessArgs &args) override {
+		if (compileDivider.process()) {
+			if (updateExpressions() || !isCompiled())
+				compile();
+		}
+		// Use the setting the cells were compiled with, until they are recompiled
+		bool fast = compiledParams[PARAM_FAST];
+		if (params[PARAM_POLY].getValue()) {
+			if (fast)
+				processPoly<AOFastMath>();
+			else
+				processPoly<AOMath>();
+		}
+		else {
+			if (fast)
+				processMono<AOFastMath>();
+			else
+				processMono<AOMath>();
+		}
+	}
+	template <typename M>
+	void processMono() {
 		float vx[x];
 		for (unsigned int ix = 0; ix < x; ix++) {
 			vx[ix] = inputs[INPUT_X_1 + ix].getVoltageSum();
 		}
+		Cell *cell = cells;
 		for (unsigned int iy = 0; iy < y; iy++) {
 			float vy = inputs[INPUT_Y_1 + iy].getVoltageSum();
-			for (unsigned int ix = 0; ix < x; ix++) {
-				unsigned int f = params[PARAM_FUNC_1 + ix + iy * x].getValue();
-				if (f >= functions.size())
-					f = functions.size() - 1;
-				if (f > 0)
-					vy = vx[ix] = functions[f].func(vx[ix], vy, ((int)params[PARAM_CONST_1 + ix + iy * x].getValue())/100.0f);
-				// if f is equal to 0, then both x and y pass (crossing) through the module unchanged.
+			for (Cell *end = cells + rowEnd[iy]; cell < end; cell++) {
+				vy = vx[cell->ix] = cell->expression?cell->expression->template run<M>(vx[cell->ix], vy, cell->c):cell->func(vx[cell->ix], vy, cell->c);
 			}
 			outputs[OUTPUT_Y_1 + iy].setVoltage(std::isfinite(vy)?vy:0.0f);
 		}
 		for (unsigned int ix = 0; ix < x; ix++) {
 			outputs[OUTPUT_X_1 + ix].setVoltage(std::isfinite(vx[ix])?vx[ix]:0.0f);
 		}
+		// The outputs may have been left polyphonic by processPoly()
+		for (unsigned int i = 0; i < NUM_OUTPUTS; i++) {
+			outputs[i].setChannels(1);
+		}
+	}
+	float_4 getInput4(unsigned int index, int c) {
+		if (!inputs[index].isConnected())
+			return 0.0f;
+		return inputs[index].getPolyVoltageSimd<float_4>(c);
+	}
+	// Each cell evaluates four channels at a time; mono inputs are spread across all channels.
+	template <typename M>
+	void processPoly() {
+		int channels = 1;
+		for (unsigned int i = 0; i < NUM_INPUTS; i++) {
+			channels = std::max(channels, inputs[i].getChannels());
+		}
+		for (int c = 0; c < channels; c += 4) {
+			float_4 vx[x];
+			for (unsigned int ix = 0; ix < x; ix++) {
+				vx[ix] = getInput4(INPUT_X_1 + ix, c);
+			}
+			Cell *cell = cells;
+			for (unsigned int iy = 0; iy < y; iy++) {
+				float_4 vy = getInput4(INPUT_Y_1 + iy, c);
+				for (Cell *end = cells + rowEnd[iy]; cell < end; cell++) {
+					vy = vx[cell->ix] = cell->expression?cell->expression->template run<M>(vx[cell->ix], vy, float_4(cell->c)):cell->func4(vx[cell->ix], vy, cell->c);
+				}
+				outputs[OUTPUT_Y_1 + iy].setVoltageSimd(M::finite(vy), c);
+			}
+			for (unsigned int ix = 0; ix < x; ix++) {
+				outputs[OUTPUT_X_1 + ix].setVoltageSimd(M::finite(vx[ix]), c);
+			}
+		}
+		for (unsigned int i = 0; i < NUM_OUTPUTS; i++) {
+			outputs[i].setChannels(channels);
+		}
 	}
 };
 
+#ifndef SUBMARINE_HEADLESS
 namespace {
 
 	struct AlgorithmMenu : MenuItem {
@@ -562,6 +1398,28 @@ namespace {
 					pm->text = "Paste";
 					menu->addChild(pm);
 				}
+				AOModule *aoModule = module;
+				int cell = index;
+				EventWidgetMenuItem *em = createMenuItem<EventWidgetMenuItem>("Expression");
+				em->rightText = SUBMENU;
+				em->childMenuHandler = [=]() {
+					Menu *menu = new Menu();
+					EventParamField *paramField = new EventParamField();
+					paramField->box.size.x = 200;
+					paramField->setText(aoModule->expressionText[cell]);
+					paramField->changeHandler = [=](std::string text) {
+						aoModule->setExpression(cell, text);
+						APP->engine->setParam(aoModule, cell, expressionFunction);
+					};
+					menu->addChild(paramField);
+					if (!aoModule->expressionError[cell].empty()) {
+						MenuLabel *label = new MenuLabel();
+						label->text = aoModule->expressionError[cell];
+						menu->addChild(label);
+					}
+					return menu;
+				};
+				menu->addChild(em);
 				menu->addChild(new MenuEntry);
 				
 				AlgorithmMenu *item = new AlgorithmMenu();
@@ -618,6 +1476,29 @@ struct AOWidget : SchemeModuleWidget {
 			}
 		}
 	}
+	void appendContextMenu(Menu *menu) override {
+		SchemeModuleWidget::appendContextMenu(menu);
+		if (!module)
+			return;
+		EventWidgetMenuItem *pmi = createMenuItem<EventWidgetMenuItem>("Polyphonic");
+		pmi->stepHandler = [=]() {
+			pmi->rightText = CHECKMARK(module->params[AO1<x,y>::PARAM_POLY].getValue());
+		};
+		pmi->clickHandler = [=]() {
+			bool val = module->params[AO1<x,y>::PARAM_POLY].getValue();
+			module->params[AO1<x,y>::PARAM_POLY].setValue(!val);
+		};
+		menu->addChild(pmi);
+		EventWidgetMenuItem *fmi = createMenuItem<EventWidgetMenuItem>("Fast Math");
+		fmi->stepHandler = [=]() {
+			fmi->rightText = CHECKMARK(module->params[AO1<x,y>::PARAM_FAST].getValue());
+		};
+		fmi->clickHandler = [=]() {
+			bool val = module->params[AO1<x,y>::PARAM_FAST].getValue();
+			module->params[AO1<x,y>::PARAM_FAST].setValue(!val);
+		};
+		menu->addChild(fmi);
+	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		char workingSpace[10];
 		snprintf(workingSpace, 10, "AO-1%02d", x * y);
@@ -679,3 +1560,4 @@ Model *modelAO112 = createModel<AO1<6,2>, AOWidget<6,2>>("A0-112");
 Model *modelAO118 = createModel<AO1<6,3>, AOWidget<6,3>>("A0-118");
 Model *modelAO124 = createModel<AO1<6,4>, AOWidget<6,4>>("A0-124");
 Model *modelAO136 = createModel<AO1<6,6>, AOWidget<6,6>>("A0-136");
+#endif
@@ -1,9 +1,12 @@
 //SubTag DS TM TW W8
 
+#include <atomic>
+#include <string.h>
 #include "shared/DS.hpp"
 
 namespace {
 
+#ifndef SUBMARINE_HEADLESS
 	NVGcolor colors[26];
 
 // Based on - Set of 20 Simple, Distinct Colors
@@ -40,25 +43,14 @@ namespace {
 		json_array_append_new(arr, json_string("#aaffc3"));
 		json_array_append_new(arr, json_string("#e6beff"));
 		json_object_set_new(settings, "colors", arr);
-		system::createDirectory(asset::user("SubmarineFree"));
-		std::string settingsFilename = asset::user("SubmarineFree/DO-1xx.json");
-		FILE *file = fopen(settingsFilename.c_str(), "w");
-		if (file) {
-			json_dumpf(settings, file, JSON_INDENT(2) | JSON_REAL_PRECISION(9));
-			fclose(file);
-		}
+		UserSettings::save("SubmarineFree/DO-1xx.json", json_deep_copy(settings));
 		return settings;
 	}
 
 	void loadJson() {
-		json_t *settings;
 		json_error_t error;
-		FILE *file = fopen(asset::user("SubmarineFree/DO-1xx.json").c_str(), "r");
-		if (file) {
-			settings = json_loadf(file, 0, &error);
-			fclose(file);
-		}
-		else {
+		json_t *settings = UserSettings::load("SubmarineFree/DO-1xx.json", &error);
+		if (!settings && !error.text[0]) {
 			settings = saveJson();
 		}
 		if (!settings) {
@@ -79,9 +71,31 @@ namespace {
 		}
 		json_decref(settings);
 	}
+#endif
 
 
 	typedef uint16_t status_t;
+	typedef status_t (*gate_t)(status_t a, status_t b, status_t c, status_t d, status_t &a0, status_t &b0, status_t &c0, status_t &d0);
+
+	// Each bit of a status_t is one polyphonic channel, channel n in bit n. Channels are
+	// thresholded and written 4 at a time.
+	status_t packStatus(Input &input, float threshold) {
+		status_t status = 0;
+		for (int c = 0; c < 16; c += 4) {
+			float_4 v = input.getPolyVoltageSimd<float_4>(c);
+			status |= _mm_movemask_ps((v > threshold).v) << c;
+		}
+		return status;
+	}
+
+	void unpackStatus(Output &output, status_t status, int channels, float voltage0, float voltage1) {
+		const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+		for (int c = 0; c < channels; c += 4) {
+			__m128i bits = _mm_and_si128(_mm_set1_epi32(status >> c), lanes);
+			float_4 mask = float_4(_mm_castsi128_ps(_mm_cmpeq_epi32(bits, lanes)));
+			output.setVoltageSimd(simd::ifelse(mask, voltage1, voltage0), c);
+		}
+	}
 
 	void drawConnector(NVGcontext *vg, float x, float y, NVGcolor color) {
 		nvgFillColor(vg, color);
@@ -199,16 +213,7 @@ namespace {
 		std::string name;
 		std::string truthTable;
 		std::function<void (const Widget::DrawArgs &, Vec size)> draw;
-		std::function<status_t (status_t a,
-					status_t b,
-					status_t c,
-					status_t d,
-					status_t &a0,
-					status_t &b0,
-					status_t &c0,
-					status_t &d0)> process;
-		
-
+		gate_t process;
 	};
 
 #define LAMBDA_HEADER [] (status_t a, status_t b, status_t c, status_t d, status_t &a0, status_t &b0, status_t &c0, status_t &d0) -> status_t
@@ -306,6 +311,96 @@ namespace {
 #undef DN
 #undef LAMBDA_HEADER
 
+	// The first character of a truth table is the number of connectors the gate reads
+	unsigned int gateInputs(const Functor &functor) {
+		unsigned int inputs = functor.truthTable[0] - '0';
+		return (inputs > 4)?4:inputs;
+	}
+
+	// Sequential gates refer to their previous state (a subscript 0) in their truth table
+	bool gateIsSequential(const Functor &functor) {
+		return functor.truthTable.find("\xE2\x82\x80") != std::string::npos;
+	}
+
+	// While compiling a netlist, each status is described as a truth table over at most 4
+	// source statuses, giving its value when source n carries termPatterns[n]. This is 
+	// enough to find gates whose output is a constant or a copy of one of their sources,
+	// however many combinational gates lie in between.
+	const status_t termPatterns[4] = { 0xAAAA, 0xCCCC, 0xF0F0, 0xFF00 };
+
+	struct Term {
+		unsigned int count = 0;
+		unsigned int sources[4];
+		status_t table = 0;
+		void setConstant(status_t value) {
+			count = 0;
+			table = value;
+		}
+		void setSource(unsigned int source) {
+			count = 1;
+			sources[0] = source;
+			table = termPatterns[0];
+		}
+		// The table re-expressed over another list of sources, which must include every 
+		// source that this term depends on.
+		status_t remap(const unsigned int *newSources, unsigned int newCount) const {
+			status_t newTable = 0;
+			for (unsigned int m = 0; m < 16; m++) {
+				unsigned int old = 0;
+				for (unsigned int j = 0; j < count; j++) {
+					for (unsigned int k = 0; k < newCount; k++) {
+						if ((newSources[k] == sources[j]) && (m & (1 << k)))
+							old |= (1 << j);
+					}
+				}
+				newTable |= ((table >> old) & 1) << m;
+			}
+			return newTable;
+		}
+		// Drop any sources that the table doesn't depend on
+		void reduce() {
+			Term reduced;
+			for (unsigned int j = 0; j < count; j++) {
+				for (unsigned int m = 0; m < 16; m++) {
+					if (((table >> m) & 1) != ((table >> (m ^ (1 << j))) & 1)) {
+						reduced.sources[reduced.count++] = sources[j];
+						break;
+					}
+				}
+			}
+			table = remap(reduced.sources, reduced.count);
+			count = reduced.count;
+			for (unsigned int j = 0; j < count; j++)
+				sources[j] = reduced.sources[j];
+		}
+		// Apply a combinational gate to terms; returns false if the result would need more 
+		// than 4 sources
+		bool apply(gate_t process, const Term *in, unsigned int inputs) {
+			count = 0;
+			for (unsigned int i = 0; i < inputs; i++) {
+				for (unsigned int j = 0; j < in[i].count; j++) {
+					unsigned int k = 0;
+					while ((k < count) && (sources[k] != in[i].sources[j]))
+						k++;
+					if (k == count) {
+						if (count == 4)
+							return false;
+						sources[count++] = in[i].sources[j];
+					}
+				}
+			}
+			status_t t[4] = { 0 };
+			for (unsigned int i = 0; i < inputs; i++) {
+				t[i] = in[i].remap(sources, count);
+			}
+			status_t a0 = 0, b0 = 0, c0 = 0, d0 = 0;
+			table = process(t[0], t[1], t[2], t[3], a0, b0, c0, d0);
+			reduce();
+			return true;
+		}
+	};
+
+#ifndef SUBMARINE_HEADLESS
 	struct PLConnectorRenderer : TransparentWidget {
 		std::function<void (const Widget::DrawArgs &)> drawLambda;
 		void draw(const DrawArgs &args) override {
@@ -383,35 +478,42 @@ namespace {
 		}
 	};
 
-	struct PLGateKnob : TooltipKnob {
-		Module *module;
-		int index;
+	// There are only 26 colours, so the gate colours repeat on the larger modules
+	template <unsigned int x>
+	unsigned int connectorColorIndex(unsigned int val) {
+		if (val < 26)
+			return val;
+		return x + 2 + (val - x - 2) % (24 - x);
+	}
+
+	template <unsigned int x>
+	NVGcolor connectorColor(unsigned int val) {
+		return colors[connectorColorIndex<x>(val)];
+	}
+
+	// The gate and connector knobs are built on either a TooltipKnob for modules which keep 
+	// their netlist in params, or a BulkKnob for those which keep it in a plain array.
+	template <class K>
+	struct PLGateKnob : K {
+		std::function<unsigned int()> getFunction;
+		NVGcolor color;
 		PLGateKnob() {
-			box.size.x = 86;
-			box.size.y = 60;
-			snap = true;
-			smooth = false;
+			this->box.size.x = 86;
+			this->box.size.y = 60;
+			this->snap = true;
+			this->smooth = false;
 		}
-		void draw(const DrawArgs &args) override {
-			if (module) {
-				unsigned int val = (unsigned int)APP->engine->getParam(module, index);
-				if (val >= functions.size()) {
-					val = functions.size() - 1;
-				}
-				functions[val].draw(args, box.size);
-				unsigned int i = box.pos.y / 80;
-				i += 6;
-				drawConnector(args.vg, box.size.x - 5, box.size.y / 2.0f, colors[i]);
+		void draw(const Widget::DrawArgs &args) override {
+			if (getFunction) {
+				functions[getFunction()].draw(args, this->box.size);
+				drawConnector(args.vg, this->box.size.x - 5, this->box.size.y / 2.0f, color);
 			}
 		}
 		void onButton(const event::Button &e) override {
-			if (module) {
+			if (getFunction) {
 				if (e.button == GLFW_MOUSE_BUTTON_RIGHT && e.action == GLFW_PRESS) {
 					e.consume(this);
-					unsigned int val = (unsigned int)APP->engine->getParam(module, index);
-					if (val >= functions.size()) {
-						val = functions.size() - 1;
-					}
+					unsigned int val = getFunction();
 					Menu *menu = createMenu();
 					MenuLabel *menuLabel = new MenuLabel();
 					menuLabel->text = functions[val].name;
@@ -421,33 +523,33 @@ namespace {
 					return;
 				}
 			}
-			Knob::onButton(e);
+			K::onButton(e);
 		}
 	};
 
-	struct PLConnectorKnob : TooltipKnob {
-		Module *module;
+	template <class K>
+	struct PLConnectorKnob : K {
 		float fade = 0.1f;
 		PLConnectorKnob() {
-			box.size.x = 10;
-			box.size.y = 10;
-			snap = true;
-			smooth = false;
+			this->box.size.x = 10;
+			this->box.size.y = 10;
+			this->snap = true;
+			this->smooth = false;
 		}
 		void step() override {
 			if (fade > 0.1f)
 				fade -= 0.02f;
 		}
 		void onDragStart(const event::DragStart &e) override {
-			Knob::onDragStart(e);
+			K::onDragStart(e);
 			fade = 0.9f;
 		}
 		void onDragMove(const event::DragMove &e) override {
-			Knob::onDragMove(e);
+			K::onDragMove(e);
 			fade = 0.9f;
 		}
 		void onDragEnd(const event::DragEnd &e) override {
-			Knob::onDragEnd(e);
+			K::onDragEnd(e);
 			fade = 0.9f;
 		}
 	};
@@ -473,18 +575,19 @@ namespace {
 			Widget::draw(args);
 		}
 	};
+#endif
 }
 
+// The gate network shared by the DO modules. The netlist gives the function of each gate,
+// then the 4 connectors of each gate, then the output connectors; where it is stored is
+// up to the module.
 template <unsigned int x, unsigned int y>
-struct DO1 : DS_Module {
-	enum ParamIds {
-		PARAM_GATE_1,
-		PARAM_CONNECTOR_1 = y,
-		PARAM_CONNECTOR_2,
-		PARAM_CONNECTOR_3,
-		PARAM_CONNECTOR_4,
-		PARAM_CONNECTOR_OUT_1 = y + 4 * y,
-		NUM_PARAMS = y + x + 4 * y
+struct DONetwork : DS_Module {
+	enum NetlistIds {
+		NETLIST_GATE_1,
+		NETLIST_CONNECTOR_1 = y,
+		NETLIST_CONNECTOR_OUT_1 = y + 4 * y,
+		NETLIST_SIZE = y + x + 4 * y
 	};
 	enum InputIds {
 		INPUT_1,
@@ -512,65 +615,386 @@ struct DO1 : DS_Module {
 
 	status_t statuses[NUM_STATUS] = { 0 };
 
-	DO1() {
-		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
-		for (unsigned int ix = 0; ix < x; ix++) {
-			configParam(PARAM_CONNECTOR_OUT_1 + ix, 0.0f, x + y + 1, 0.0f, "Connection" );
-		}
-		for (unsigned int iy = 0; iy < y; iy++) {
-			configParam(PARAM_GATE_1 + iy, 0.0f, functions.size() - 1.0f, 0.0f, "Gate" );
-			configParam(PARAM_CONNECTOR_1 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
-			configParam(PARAM_CONNECTOR_2 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
-			configParam(PARAM_CONNECTOR_3 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
-			configParam(PARAM_CONNECTOR_4 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
-		}
+	// The wiring is compiled into a list of the gates which affect an output, in order,
+	// with their connections already decoded. Gates which are constant or just copy one of 
+	// their inputs are folded into their consumers. Sequential gates are always kept so 
+	// that their state is up to date if they are reconnected.
+	struct Instruction {
+		gate_t process;
+		unsigned int gate;
+		unsigned int in[4];
+		bool pending;
+	};
+	Instruction program[y];
+	unsigned int programLength = 0;
+	unsigned int outputSources[x];
+	unsigned int liveGates = 0;
+	float compiledNetlist[NETLIST_SIZE] = { 0 };
+	dsp::ClockDivider compileDivider;
+
+	// Gates are only evaluated when one of their inputs changed on this frame, or when their
+	// own state changed last time they were evaluated. Gates are pure functions of their 
+	// inputs and state, so anything else would give the same result again. Outputs are only
+	// rewritten when their source changes, and every so often in case the engine has 
+	// cleared them.
+	uint32_t frame = 0;
+	uint32_t changedAt[STATUS_A0] = { 0 };
+	bool refreshOutputs = true;
+	float outputVoltage0 = 0.0f;
+	float outputVoltage1 = 0.0f;
+
+	DONetwork() {
 		statuses[STATUS_ALL_ZEROES] = 0;
 		statuses[STATUS_ALL_ONES] = ~statuses[STATUS_ALL_ZEROES];
+		compileDivider.setDivision(32);
+		compile();
+#ifndef SUBMARINE_HEADLESS
 		loadJson();
+#endif
 	}
-	void process(const ProcessArgs &args) override {
-		unsigned int maxPoly = 0;
+	static float netlistMaximum(unsigned int id) {
+		if (id < NETLIST_CONNECTOR_1)
+			return functions.size() - 1.0f;
+		if (id < NETLIST_CONNECTOR_OUT_1)
+			return 1 + x + (id - NETLIST_CONNECTOR_1) / 4;
+		return x + y + 1;
+	}
+	// Copy the netlist into compiledNetlist, returning true if it has changed
+	virtual bool updateNetlist() = 0;
+	// Called from the UI thread
+	void checkNetlist() {}
+	void compile() {
+		// sources[n] is the status to read in place of status n
+		Term terms[STATUS_A0];
+		unsigned int sources[STATUS_A0];
+		terms[STATUS_ALL_ZEROES].setConstant(0);
+		sources[STATUS_ALL_ZEROES] = STATUS_ALL_ZEROES;
+		terms[STATUS_ALL_ONES].setConstant(0xFFFF);
+		sources[STATUS_ALL_ONES] = STATUS_ALL_ONES;
 		for (unsigned int ix = 0; ix < x; ix++) {
-			unsigned int channels = inputs[INPUT_1 + ix].getChannels();
-			maxPoly = (maxPoly > channels)?maxPoly:channels;
-			statuses[STATUS_A + ix] = 0;
-			for (unsigned int iy = 0; iy < 16; iy++) {
-				statuses[STATUS_A + ix] <<= 1;
-				statuses[STATUS_A + ix] += (inputs[INPUT_1 + ix].getPolyVoltage(iy) > midpoint());
-			}
+			terms[STATUS_A + ix].setSource(STATUS_A + ix);
+			sources[STATUS_A + ix] = STATUS_A + ix;
 		}
+		bool needed[y];
+		bool sequential[y];
+		Instruction gates[y];
 		for (unsigned int iy = 0; iy < y; iy++) {
-			unsigned int gate = params[PARAM_GATE_1 + iy].getValue();
+			unsigned int gate = compiledNetlist[NETLIST_GATE_1 + iy];
 			if (gate >= functions.size()) {
 				gate = functions.size() - 1;
 			}
-			status_t in[4];
+			unsigned int inputs = gateInputs(functions[gate]);
+			Term in[4];
+			gates[iy].process = functions[gate].process;
+			gates[iy].gate = iy;
 			for (unsigned int ix = 0; ix < 4; ix++) {
-				unsigned int val = params[PARAM_CONNECTOR_1 + ix + 4 * iy].getValue();
+				unsigned int val = compiledNetlist[NETLIST_CONNECTOR_1 + ix + 4 * iy];
 				if (val > x + iy + 1)
 					val = x + iy + 1;
-				in[ix] = statuses[STATUS_ALL_ZEROES + val];
+				// Connectors that the gate doesn't read are tied low so that they don't keep
+				// other gates alive
+				if (ix >= inputs)
+					val = STATUS_ALL_ZEROES;
+				gates[iy].in[ix] = sources[STATUS_ALL_ZEROES + val];
+				in[ix] = terms[STATUS_ALL_ZEROES + val];
+			}
+			unsigned int status = STATUS_OUT + iy;
+			sequential[iy] = gateIsSequential(functions[gate]);
+			needed[iy] = true;
+			sources[status] = status;
+			if (sequential[iy] || !terms[status].apply(gates[iy].process, in, inputs)) {
+				terms[status].setSource(status);
+			}
+			else if (terms[status].count == 0) {
+				sources[status] = terms[status].table?STATUS_ALL_ONES:STATUS_ALL_ZEROES;
+				needed[iy] = false;
+			}
+			else if ((terms[status].count == 1) && (terms[status].table == termPatterns[0])) {
+				sources[status] = terms[status].sources[0];
+				needed[iy] = false;
 			}
-			statuses[STATUS_OUT + iy] = functions[gate].process(in[0], in[1], in[2], in[3], statuses[STATUS_A0 + iy], statuses[STATUS_B0 + iy], statuses[STATUS_C0 + iy], statuses[STATUS_D0 + iy]);
 		}
+		// Work back from the outputs to find which of the remaining gates are live
+		bool live[y] = { false };
 		for (unsigned int ix = 0; ix < x; ix++) {
-			outputs[OUTPUT_1 + ix].setChannels(maxPoly);
-			unsigned int val = params[PARAM_CONNECTOR_OUT_1 + ix].getValue();
+			unsigned int val = compiledNetlist[NETLIST_CONNECTOR_OUT_1 + ix];
 			if (val > 1 + x + y)
 				val = 1 + x + y;
-			for (unsigned int iy = 0; iy < 16; iy++) {
-				outputs[OUTPUT_1 + ix].setVoltage(((statuses[STATUS_ALL_ZEROES + val] >> (15-iy)) & 0x1)?voltage1:voltage0, iy);
+			outputSources[ix] = sources[STATUS_ALL_ZEROES + val];
+			if (outputSources[ix] >= STATUS_OUT)
+				live[outputSources[ix] - STATUS_OUT] = true;
+		}
+		for (unsigned int iy = y; iy-- > 0;) {
+			live[iy] = needed[iy] && (live[iy] || sequential[iy]);
+			if (live[iy]) {
+				for (unsigned int ix = 0; ix < 4; ix++) {
+					if (gates[iy].in[ix] >= STATUS_OUT)
+						live[gates[iy].in[ix] - STATUS_OUT] = true;
+				}
+			}
+		}
+		programLength = 0;
+		for (unsigned int iy = 0; iy < y; iy++) {
+			if (live[iy]) {
+				program[programLength] = gates[iy];
+				program[programLength++].pending = true;
 			}
 		}
+		liveGates = programLength;
+		refreshOutputs = true;
+	}
+	void process(const ProcessArgs &args) override {
+		if (compileDivider.process()) {
+			if (updateNetlist())
+				compile();
+			refreshOutputs = true;
+		}
+		frame++;
+		unsigned int maxPoly = 0;
+		float threshold = midpoint();
+		for (unsigned int ix = 0; ix < x; ix++) {
+			unsigned int channels = inputs[INPUT_1 + ix].getChannels();
+			maxPoly = (maxPoly > channels)?maxPoly:channels;
+			status_t status = packStatus(inputs[INPUT_1 + ix], threshold);
+			if (status != statuses[STATUS_A + ix]) {
+				statuses[STATUS_A + ix] = status;
+				changedAt[STATUS_A + ix] = frame;
+			}
+		}
+		for (Instruction *ins = program, *end = program + programLength; ins < end; ins++) {
+			if (!ins->pending && (changedAt[ins->in[0]] != frame) && (changedAt[ins->in[1]] != frame) && (changedAt[ins->in[2]] != frame) && (changedAt[ins->in[3]] != frame))
+				continue;
+			unsigned int iy = ins->gate;
+			status_t a0 = statuses[STATUS_A0 + iy];
+			status_t b0 = statuses[STATUS_B0 + iy];
+			status_t c0 = statuses[STATUS_C0 + iy];
+			status_t d0 = statuses[STATUS_D0 + iy];
+			status_t out = ins->process(statuses[ins->in[0]], statuses[ins->in[1]], statuses[ins->in[2]], statuses[ins->in[3]], statuses[STATUS_A0 + iy], statuses[STATUS_B0 + iy], statuses[STATUS_C0 + iy], statuses[STATUS_D0 + iy]);
+			ins->pending = (a0 != statuses[STATUS_A0 + iy]) || (b0 != statuses[STATUS_B0 + iy]) || (c0 != statuses[STATUS_C0 + iy]) || (d0 != statuses[STATUS_D0 + iy]);
+			if (out != statuses[STATUS_OUT + iy]) {
+				statuses[STATUS_OUT + iy] = out;
+				changedAt[STATUS_OUT + iy] = frame;
+			}
+		}
+		if ((voltage0 != outputVoltage0) || (voltage1 != outputVoltage1)) {
+			outputVoltage0 = voltage0;
+			outputVoltage1 = voltage1;
+			refreshOutputs = true;
+		}
+		// An output with no connected inputs still carries 1 channel
+		int channels = maxPoly?maxPoly:1;
+		for (unsigned int ix = 0; ix < x; ix++) {
+			// A disconnected output stays at 0 channels, so it would never match
+			if (!outputs[OUTPUT_1 + ix].isConnected())
+				continue;
+			if (refreshOutputs || (changedAt[outputSources[ix]] == frame) || (outputs[OUTPUT_1 + ix].getChannels() != channels)) {
+				outputs[OUTPUT_1 + ix].setChannels(channels);
+				unpackStatus(outputs[OUTPUT_1 + ix], statuses[outputSources[ix]], channels, voltage0, voltage1);
+			}
+		}
+		refreshOutputs = false;
 	}
 };
 
 template <unsigned int x, unsigned int y>
+struct DO1 : DONetwork<x, y> {
+	enum ParamIds {
+		PARAM_GATE_1,
+		PARAM_CONNECTOR_1 = y,
+		PARAM_CONNECTOR_2,
+		PARAM_CONNECTOR_3,
+		PARAM_CONNECTOR_4,
+		PARAM_CONNECTOR_OUT_1 = y + 4 * y,
+		NUM_PARAMS = y + x + 4 * y
+	};
+#ifndef SUBMARINE_HEADLESS
+	typedef TooltipKnob KnobBase;
+#endif
+	DO1() {
+		this->config(NUM_PARAMS, DONetwork<x, y>::NUM_INPUTS, DONetwork<x, y>::NUM_OUTPUTS, DONetwork<x, y>::NUM_LIGHTS);
+		for (unsigned int ix = 0; ix < x; ix++) {
+			this->configParam(PARAM_CONNECTOR_OUT_1 + ix, 0.0f, x + y + 1, 0.0f, "Connection" );
+		}
+		for (unsigned int iy = 0; iy < y; iy++) {
+			this->configParam(PARAM_GATE_1 + iy, 0.0f, functions.size() - 1.0f, 0.0f, "Gate" );
+			this->configParam(PARAM_CONNECTOR_1 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
+			this->configParam(PARAM_CONNECTOR_2 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
+			this->configParam(PARAM_CONNECTOR_3 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
+			this->configParam(PARAM_CONNECTOR_4 + 4 * iy, 0.0f, 1 + x + iy, 0.0f, "Connection");
+		}
+	}
+	static std::string title() {
+		return string::f("DO-1%02d", y);
+	}
+	bool updateNetlist() override {
+		bool changed = false;
+		for (unsigned int i = 0; i < NUM_PARAMS; i++) {
+			if (this->params[i].getValue() != this->compiledNetlist[i]) {
+				this->compiledNetlist[i] = this->params[i].getValue();
+				changed = true;
+			}
+		}
+		return changed;
+	}
+	float getNetlistValue(unsigned int id) {
+		return this->params[id].getValue();
+	}
+	float *getNetlistPointer(unsigned int id) {
+		return NULL;
+	}
+};
+
+// Larger networks would need thousands of params, so the netlist is kept in an array which 
+// is edited with bulk knobs, and saved in a compact form.
+template <unsigned int x, unsigned int y>
+struct DO2 : DONetwork<x, y> {
+#ifndef SUBMARINE_HEADLESS
+	typedef BulkKnob KnobBase;
+#endif
+	enum {
+		NETLIST_SIZE = DONetwork<x, y>::NETLIST_SIZE
+	};
+	float netlist[NETLIST_SIZE] = { 0 };
+	float checkedNetlist[NETLIST_SIZE] = { 0 };
+	std::atomic<unsigned int> netlistVersion { 0 };
+	unsigned int compiledVersion = 0;
+	DO2() {
+		this->config(0, DONetwork<x, y>::NUM_INPUTS, DONetwork<x, y>::NUM_OUTPUTS, DONetwork<x, y>::NUM_LIGHTS);
+	}
+	static std::string title() {
+		return string::f("DO-%d", y);
+	}
+	// The knobs write straight into the netlist, so the widget looks for changes on the UI
+	// thread rather than the engine comparing the whole netlist every time.
+	void checkNetlist() {
+		if (memcmp(netlist, checkedNetlist, sizeof(netlist))) {
+			memcpy(checkedNetlist, netlist, sizeof(netlist));
+			netlistVersion++;
+		}
+	}
+	bool updateNetlist() override {
+		unsigned int version = netlistVersion;
+		if (version == compiledVersion)
+			return false;
+		compiledVersion = version;
+		memcpy(this->compiledNetlist, netlist, sizeof(netlist));
+		return true;
+	}
+	float getNetlistValue(unsigned int id) {
+		return netlist[id];
+	}
+	float *getNetlistPointer(unsigned int id) {
+		return netlist + id;
+	}
+	void onReset() override {
+		DONetwork<x, y>::onReset();
+		for (unsigned int i = 0; i < NETLIST_SIZE; i++)
+			netlist[i] = 0.0f;
+		netlistVersion++;
+	}
+	// Each gate is saved as [function, connector 1, connector 2, connector 3, connector 4],
+	// leaving out any unused gates at the end
+	json_t *dataToJson() override {
+		json_t *rootJ = DONetwork<x, y>::dataToJson();
+		json_t *netlistJ = json_object();
+		unsigned int used = y;
+		while (used > 0) {
+			bool empty = true;
+			for (unsigned int i = 0; i < 5; i++) {
+				if (gateValue(used - 1, i))
+					empty = false;
+			}
+			if (!empty)
+				break;
+			used--;
+		}
+		json_t *gatesJ = json_array();
+		for (unsigned int iy = 0; iy < used; iy++) {
+			json_t *gateJ = json_array();
+			for (unsigned int i = 0; i < 5; i++)
+				json_array_append_new(gateJ, json_integer(gateValue(iy, i)));
+			json_array_append_new(gatesJ, gateJ);
+		}
+		json_object_set_new(netlistJ, "gates", gatesJ);
+		json_t *outputsJ = json_array();
+		for (unsigned int ix = 0; ix < x; ix++)
+			json_array_append_new(outputsJ, json_integer((int)netlist[DONetwork<x, y>::NETLIST_CONNECTOR_OUT_1 + ix]));
+		json_object_set_new(netlistJ, "outputs", outputsJ);
+		json_object_set_new(rootJ, "netlist", netlistJ);
+		return rootJ;
+	}
+	void dataFromJson(json_t *rootJ) override {
+		DONetwork<x, y>::dataFromJson(rootJ);
+		json_t *netlistJ = json_object_get(rootJ, "netlist");
+		if (!netlistJ)
+			return;
+		for (unsigned int i = 0; i < NETLIST_SIZE; i++)
+			netlist[i] = 0.0f;
+		json_t *gatesJ = json_object_get(netlistJ, "gates");
+		if (gatesJ) {
+			unsigned int size = json_array_size(gatesJ);
+			if (size > y)
+				size = y;
+			for (unsigned int iy = 0; iy < size; iy++) {
+				json_t *gateJ = json_array_get(gatesJ, iy);
+				for (unsigned int i = 0; i < 5; i++) {
+					json_t *j1 = json_array_get(gateJ, i);
+					if (j1) {
+						unsigned int id = i?(DONetwork<x, y>::NETLIST_CONNECTOR_1 + 4 * iy + i - 1):(DONetwork<x, y>::NETLIST_GATE_1 + iy);
+						netlist[id] = clampNetlistValue(id, json_integer_value(j1));
+					}
+				}
+			}
+		}
+		json_t *outputsJ = json_object_get(netlistJ, "outputs");
+		if (outputsJ) {
+			for (unsigned int ix = 0; ix < x; ix++) {
+				json_t *j1 = json_array_get(outputsJ, ix);
+				if (j1) {
+					unsigned int id = DONetwork<x, y>::NETLIST_CONNECTOR_OUT_1 + ix;
+					netlist[id] = clampNetlistValue(id, json_integer_value(j1));
+				}
+			}
+		}
+		netlistVersion++;
+	}
+	int gateValue(unsigned int iy, unsigned int i) {
+		if (i)
+			return netlist[DONetwork<x, y>::NETLIST_CONNECTOR_1 + 4 * iy + i - 1];
+		return netlist[DONetwork<x, y>::NETLIST_GATE_1 + iy];
+	}
+	float clampNetlistValue(unsigned int id, json_int_t value) {
+		if (value < 0)
+			return 0.0f;
+		return std::min((float)value, DONetwork<x, y>::netlistMaximum(id));
+	}
+};
+
+#ifndef SUBMARINE_HEADLESS
+template <template <class> class K, unsigned int x, unsigned int y>
+K<TooltipKnob> *createNetlistKnob(Vec pos, DO1<x, y> *module, unsigned int id) {
+	return createParamCentered<K<TooltipKnob>>(pos, module, id);
+}
+
+template <template <class> class K, unsigned int x, unsigned int y>
+K<BulkKnob> *createNetlistKnob(Vec pos, DO2<x, y> *module, unsigned int id) {
+	K<BulkKnob> *knob = new K<BulkKnob>();
+	knob->box.pos = pos.minus(knob->box.size.div(2));
+	knob->maxValue = DONetwork<x, y>::netlistMaximum(id);
+	knob->module = module;
+	knob->paramId = id;
+	if (module)
+		knob->value = module->netlist + id;
+	return knob;
+}
+
+template <unsigned int x, unsigned int y, class M>
 struct DOWidget : SchemeModuleWidget {
+	typedef typename M::KnobBase KnobBase;
 	ScrollWidget *collectionScrollWidget;
-	PLConnectorKnob *knobs[x + 4 * y];
+	PLConnectorKnob<KnobBase> *knobs[x + 4 * y];
 	PLBackground<x,y> *background;
-	DOWidget(DO1<x,y> *module) {
+	DOWidget(M *module) {
 		setModule(module);
 		this->box.size = Vec(x * 30, 380);
 		addChild(new SchemePanel(this->box.size));
@@ -582,8 +1006,7 @@ struct DOWidget : SchemeModuleWidget {
 		float posDiff = background->box.size.x / x;
 		float pos = posDiff / 2;
 		for (unsigned int ix = 0; ix < x; ix++) {
-			knobs[ix + 4 * y] = createParamCentered<PLConnectorKnob>(Vec(pos, background->box.size.y - 5), module, DO1<x, y>::PARAM_CONNECTOR_OUT_1 + ix);
-			knobs[ix + 4 * y]->module = module;
+			knobs[ix + 4 * y] = createNetlistKnob<PLConnectorKnob>(Vec(pos, background->box.size.y - 5), module, M::NETLIST_CONNECTOR_OUT_1 + ix);
 			knobs[ix + 4 * y]->getText = [=]()->std::string {
 				return this->getConnectorText(ix + 4 * y);
 			};
@@ -595,9 +1018,13 @@ struct DOWidget : SchemeModuleWidget {
 		collectionScrollWidget->box.size = Vec(box.size.x - 10, box.size.y - 110);
 		addChild(collectionScrollWidget);
 		for (unsigned int iy = 0; iy < y; iy++) {
-			PLGateKnob *knob = createParamCentered<PLGateKnob>(Vec(53, 80 * (iy + 1)), module, DO1<x,y>::PARAM_GATE_1 + iy);
-			knob->module = module;
-			knob->index = DO1<x,y>::PARAM_GATE_1 + iy;
+			PLGateKnob<KnobBase> *knob = createNetlistKnob<PLGateKnob>(Vec(53, 80 * (iy + 1)), module, M::NETLIST_GATE_1 + iy);
+			if (module) {
+				knob->getFunction = [=]()->unsigned int {
+					return this->getGateFunction(iy);
+				};
+			}
+			knob->color = connectorColor<x>(x + 2 + iy);
 			knob->getText = [=]()->std::string {
 				return this->getGateText(iy);
 			};
@@ -605,8 +1032,7 @@ struct DOWidget : SchemeModuleWidget {
 		}
 		for (unsigned int iy = 0; iy < y; iy++) {
 			for (unsigned int ix = 0; ix < 4; ix++) {
-				knobs[4 * iy + ix] = createParamCentered<PLConnectorKnob>(Vec(5, (iy + 1) * 80.0f + ix * 14.0f - 21.0f), module, DO1<x, y>::PARAM_CONNECTOR_1 + iy * 4 + ix);
-				knobs[4 * iy + ix]->module = module;
+				knobs[4 * iy + ix] = createNetlistKnob<PLConnectorKnob>(Vec(5, (iy + 1) * 80.0f + ix * 14.0f - 21.0f), module, M::NETLIST_CONNECTOR_1 + iy * 4 + ix);
 				knobs[4 * iy + ix]->getText = [=]()->std::string {
 					return this->getConnectorText(4 * iy + ix);
 				};
@@ -622,17 +1048,25 @@ struct DOWidget : SchemeModuleWidget {
 		};
 		addChild(renderer);
 		for (unsigned int ix = 0; ix < x; ix++) {
-			addInput(createInputCentered<BluePort>(Vec(15 + ix * 30, 30), module, DO1<x,y>::INPUT_1 + ix));
-			addOutput(createOutputCentered<BluePort>(Vec(15 + ix * 30, 350), module, DO1<x,y>::OUTPUT_1 + ix));
+			addInput(createInputCentered<BluePort>(Vec(15 + ix * 30, 30), module, M::INPUT_1 + ix));
+			addOutput(createOutputCentered<BluePort>(Vec(15 + ix * 30, 350), module, M::OUTPUT_1 + ix));
 		}
 	}
 
-	std::string getGateName(unsigned int index) {
-		unsigned int val = (unsigned int)APP->engine->getParam(module, DO1<x,y>::PARAM_GATE_1 + index);
+	float getNetlistValue(unsigned int id) {
+		return static_cast<M *>(module)->getNetlistValue(id);
+	}
+
+	unsigned int getGateFunction(unsigned int index) {
+		unsigned int val = (unsigned int)getNetlistValue(M::NETLIST_GATE_1 + index);
 		if (val >= functions.size()) {
 			val = functions.size() - 1;
 		}
-		return functions[val].name;
+		return val;
+	}
+
+	std::string getGateName(unsigned int index) {
+		return functions[getGateFunction(index)].name;
 	}
 
 	std::string getGateText(unsigned int index) {
@@ -655,7 +1089,7 @@ struct DOWidget : SchemeModuleWidget {
 		if (!module)
 			return std::string("Browser");
 		std::string connectorName = getConnectorNameText(index);
-		unsigned int val = (unsigned int)APP->engine->getParam(module, DO1<x,y>::PARAM_CONNECTOR_1 + index);	
+		unsigned int val = (unsigned int)getNetlistValue(M::NETLIST_CONNECTOR_1 + index);
 		if (val > x + y + 1)
 			val = x + y + 1;
 		if (val == 0)
@@ -667,13 +1101,83 @@ struct DOWidget : SchemeModuleWidget {
 		return connectorName + string::f("Gate %d: ", val - x -1) + getGateName(val - x - 2);
 	}
 
-	void drawWire(const DrawArgs &args, float sx, float sy, float dx, float dy, NVGcolor color, float fade) {
-		drawConnector(args.vg, sx, sy, color);
+	// Wire geometry only changes when a connector is moved or the gates are scrolled, so it
+	// is cached, sorted by clipping and colour, and drawn in batches. Only the wires which
+	// are still fading after being moved are drawn one at a time.
+	struct Wire {
+		float startX;
+		float startY;
+		float destX;
+		float destY;
+		unsigned int knob;
+		unsigned int color;
+		// bit 0: starts in the scrolling area, bit 1: ends in the scrolling area
+		unsigned int clip;
+		bool line;
+	};
+	std::vector<Wire> wires;
+	float wireValues[x + 4 * y];
+	float wireScroll = NAN;
+
+	bool wiresChanged() {
+		bool changed = (wireScroll != collectionScrollWidget->container->box.pos.y);
+		wireScroll = collectionScrollWidget->container->box.pos.y;
+		for (unsigned int i = 0; i < x + 4 * y; i++) {
+			float val = getNetlistValue(M::NETLIST_CONNECTOR_1 + i);
+			if (val != wireValues[i]) {
+				wireValues[i] = val;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+	void buildWires() {
+		wires.clear();
+		for (unsigned int i = 0; i < x + 4 * y; i++) {
+			Wire wire;
+			wire.knob = i;
+			wire.clip = 0;
+			if (i < 4 * y) {
+				wire.startX = 5;
+				wire.startY = (i / 4) * 80.0f + wireScroll;
+				wire.startY += (i % 4) * 14.0f + 69.0f;
+				wire.clip |= 1;
+			}
+			else {
+				wire.startX = (background->box.size.x / (x * 2)) * ((i - 4 * y) * 2 + 1);
+				wire.startY = background->box.size.y - 5;
+			}
+			unsigned int val = (unsigned int)wireValues[i];
+			if (val > (x + y + 1)) {
+				val = (x + y + 1);
+			}
+			if (val < x + 2) {
+				wire.destX = background->box.size.x / (x + 2);
+				wire.destX /= 2;
+				wire.destX *= (val * 2 + 1);
+				wire.destY = 5;
+			}
+			else {
+				wire.destX = 91.0f; 
+				wire.destY = 10 + 80 * (val - x - 1) + wireScroll;
+				wire.clip |= 2;
+			}
+			wire.color = connectorColorIndex<x>(val);
+			// Wires from the low pad are never shown, only their pads
+			wire.line = (val != 0);
+			wires.push_back(wire);
+		}
+		std::sort(wires.begin(), wires.end(), [](const Wire &a, const Wire &b) {
+			if (a.clip != b.clip)
+				return a.clip < b.clip;
+			return a.color < b.color;
+		});
+	}
+	void drawWire(const DrawArgs &args, const Wire &wire, NVGcolor color, float fade) {
 		color.a = fade;
 		nvgBeginPath(args.vg);
-		nvgMoveTo(args.vg, sx, sy);
-		nvgLineTo(args.vg, dx, dy);
-		nvgLineCap(args.vg, NVG_ROUND);
+		nvgMoveTo(args.vg, wire.startX, wire.startY);
+		nvgLineTo(args.vg, wire.destX, wire.destY);
 		nvgStrokeColor(args.vg, nvgRGBAf(color.r / 2.0f, color.g / 2.0f, color.b / 2.0f, fade));
 		nvgStrokeWidth(args.vg, 3);
 		nvgStroke(args.vg);
@@ -684,58 +1188,85 @@ struct DOWidget : SchemeModuleWidget {
 	void drawConnectors(const DrawArgs &args) {
 		if (!module)
 			return;
+		nvgBeginPath(args.vg);
 		for (unsigned int i = 0; i < x; i++) {
-			nvgBeginPath(args.vg);
-			nvgStrokeWidth(args.vg, 2);
-			nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
 			nvgMoveTo(args.vg, (background->box.size.x / (x * 2)) * (i * 2 + 1), background->box.size.y - 5);
 			nvgLineTo(args.vg, 15 + i * 30 - background->box.pos.x, 350 - background->box.pos.y);
-			nvgStroke(args.vg);
 		}
-		for (unsigned int i = 0; i < x + 4 * y; i++) {
-			float startX = 0;
-			float startY = 0;
-			float destX = 0;
-			float destY = 0;
-			float scissorTop = args.clipBox.pos.y;
-			float scissorBottom = args.clipBox.size.y;
-			if (i < 4 * y) {
-				startX = 5;
-				startY = (i / 4) * 80.0f + collectionScrollWidget->container->box.pos.y;
-				startY += (i % 4) * 14.0f + 69.0f;
-				scissorBottom -= 10;
+		nvgStrokeWidth(args.vg, 2);
+		nvgStrokeColor(args.vg, nvgRGB(255, 255, 255));
+		nvgStroke(args.vg);
+		if (wiresChanged())
+			buildWires();
+		nvgLineCap(args.vg, NVG_ROUND);
+		float clipTop = args.clipBox.pos.y;
+		float clipBottom = args.clipBox.pos.y + args.clipBox.size.y;
+		unsigned int clip = 4;
+		unsigned int count = wires.size();
+		for (unsigned int start = 0, end = 0; start < count; start = end) {
+			while ((end < count) && (wires[end].clip == wires[start].clip) && (wires[end].color == wires[start].color))
+				end++;
+			if (wires[start].clip != clip) {
+				clip = wires[start].clip;
+				float scissorTop = clipTop;
+				float scissorHeight = args.clipBox.size.y;
+				if (clip & 1) {
+					scissorHeight -= 10;
+				}
+				if (clip & 2) {
+					scissorTop += 10;
+					scissorHeight -= 10;
+				}
+				nvgScissor(args.vg, args.clipBox.pos.x, scissorTop, args.clipBox.size.x, scissorHeight);
 			}
-			else {
-				startX = (background->box.size.x / (x * 2)) * ((i - 4 * y) * 2 + 1);
-				startY = background->box.size.y - 5;
+			NVGcolor color = colors[wires[start].color];
+			bool idle = false;
+			nvgBeginPath(args.vg);
+			for (unsigned int i = start; i < end; i++) {
+				const Wire &wire = wires[i];
+				if (!wire.line || (knobs[wire.knob]->fade > 0.1f))
+					continue;
+				// Wires which are scrolled out of view can be skipped entirely
+				if ((std::max(wire.startY, wire.destY) + 5 < clipTop) || (std::min(wire.startY, wire.destY) - 5 > clipBottom))
+					continue;
+				nvgMoveTo(args.vg, wire.startX, wire.startY);
+				nvgLineTo(args.vg, wire.destX, wire.destY);
+				idle = true;
 			}
-			unsigned int val = (unsigned int)APP->engine->getParam(module, DO1<x,y>::PARAM_CONNECTOR_1 + i);
-			if (val > (x + y + 1)) {
-				val = (x + y + 1);
+			if (idle) {
+				nvgStrokeColor(args.vg, nvgRGBAf(color.r / 2.0f, color.g / 2.0f, color.b / 2.0f, 0.1f));
+				nvgStrokeWidth(args.vg, 3);
+				nvgStroke(args.vg);
+				nvgStrokeColor(args.vg, nvgRGBAf(color.r, color.g, color.b, 0.1f));
+				nvgStrokeWidth(args.vg, 2);
+				nvgStroke(args.vg);
 			}
-			if (val < x + 2) {
-				destX = background->box.size.x / (x + 2);
-				destX /= 2;
-				destX *= (val * 2 + 1);
-				destY = 5;
+			for (unsigned int i = start; i < end; i++) {
+				if (wires[i].line && (knobs[wires[i].knob]->fade > 0.1f))
+					drawWire(args, wires[i], color, knobs[wires[i].knob]->fade);
 			}
-			else {
-				destX = 91.0f; 
-				destY = 10 + 80 * (val - x - 1) + collectionScrollWidget->container->box.pos.y;
-				scissorTop += 10;
-				scissorBottom -= 10;
+			nvgBeginPath(args.vg);
+			for (unsigned int i = start; i < end; i++) {
+				if ((wires[i].startY + 5 >= clipTop) && (wires[i].startY - 5 <= clipBottom))
+					nvgCircle(args.vg, wires[i].startX, wires[i].startY, 4);
 			}
-			nvgScissor(args.vg, args.clipBox.pos.x, scissorTop, args.clipBox.size.x, scissorBottom);
-			NVGcolor color = colors[val];
-			float fade = val?knobs[i]->fade:0.0f;
-			drawWire(args, startX, startY, destX, destY, color, fade);
-			nvgResetScissor(args.vg);
+			nvgFillColor(args.vg, color);
+			nvgFill(args.vg);
 		}
+		nvgResetScissor(args.vg);
 	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
-		char workingSpace[10];
-		snprintf(workingSpace, 10, "DO-1%02d", y);
-		drawBase(vg, workingSpace);
+		drawBase(vg, M::title().c_str());
+	}
+	void step() override {
+		if (module)
+			static_cast<M *>(module)->checkNetlist();
+		SchemeModuleWidget::step();
+	}
+	float *getBulkParam(int id) override {
+		if (!module || (id < 0) || (id >= M::NETLIST_SIZE))
+			return NULL;
+		return static_cast<M *>(module)->getNetlistPointer(id);
 	}
 	void appendContextMenu(Menu *menu) override {
 		SchemeModuleWidget::appendContextMenu(menu);
@@ -743,10 +1274,18 @@ struct DOWidget : SchemeModuleWidget {
 		if (dsMod) {
 			dsMod->appendContextMenu(menu);
 		}
+		M *doMod = dynamic_cast<M *>(module);
+		if (doMod) {
+			MenuLabel *menuLabel = new MenuLabel();
+			menuLabel->text = string::f("Live gates: %d of %d", doMod->liveGates, y);
+			menu->addChild(menuLabel);
+		}
 	}
 };
 
-Model *modelDO105 = createModel<DO1<4,5>, DOWidget<4,5>>("DO-105");
-Model *modelDO110 = createModel<DO1<4,10>, DOWidget<4,10>>("DO-110");
-Model *modelDO115 = createModel<DO1<4,15>, DOWidget<4,15>>("DO-115");
-Model *modelDO120 = createModel<DO1<4,20>, DOWidget<4,20>>("DO-120");
+Model *modelDO105 = createModel<DO1<4,5>, DOWidget<4,5,DO1<4,5>>>("DO-105");
+Model *modelDO110 = createModel<DO1<4,10>, DOWidget<4,10,DO1<4,10>>>("DO-110");
+Model *modelDO115 = createModel<DO1<4,15>, DOWidget<4,15,DO1<4,15>>>("DO-115");
+Model *modelDO120 = createModel<DO1<4,20>, DOWidget<4,20,DO1<4,20>>>("DO-120");
+Model *modelDO200 = createModel<DO2<8,200>, DOWidget<8,200,DO2<8,200>>>("DO-200");
+#endif
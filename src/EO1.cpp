@@ -3,9 +3,126 @@
 /* Portions of this code derive from Fundamental/src/Scope.cpp - Copyright 2017 by Andrew Belt */
 #include <string.h>
 #include "SubmarineFree.hpp"
+#include "shared/TripleBuffer.hpp"
 
 #define BUFFER_SIZE 800
 #define PRE_SIZE 100
+#define DISPLAY_COLUMNS 400
+#define MAX_BLOCKS 4
+#define DEEP_CHUNK 65536
+#define DEEP_LEVELS 8
+
+namespace {
+	// Channels are captured four at a time; channel n is in lane n % 4 of block n / 4.
+	struct EO_Frame {
+		float_4 buffer[2][MAX_BLOCKS][BUFFER_SIZE];
+		// The lowest and highest value in each pixel column of the display, taken from
+		// every sample rather than just the ones kept in buffer. rising is 1 if the
+		// highest value came after the lowest.
+		float_4 low[2][MAX_BLOCKS][DISPLAY_COLUMNS];
+		float_4 high[2][MAX_BLOCKS][DISPLAY_COLUMNS];
+		float_4 rising[2][MAX_BLOCKS][DISPLAY_COLUMNS];
+		int channels[2];
+		int traceMode[2];
+		int preCount;
+		// The rate of the kept samples, and whether the sweep had finished
+		float sampleRate;
+		bool complete;
+	};
+
+	// Deep memory keeps every sample of channel 0 of each input. Each chunk also holds a 
+	// min/max pyramid: level l has one low/high pair for every 4^(l+1) samples, up to a 
+	// single pair for the whole chunk, so any span can be measured from a few entries.
+	struct EO_DeepChunk {
+		float raw[2][DEEP_CHUNK];
+		float pyramid[2][(DEEP_CHUNK / 3) * 2];
+	};
+
+	struct EO_Deep {
+		std::vector<EO_DeepChunk> chunks;
+		unsigned int offsets[DEEP_LEVELS];
+		std::atomic<uint64_t> written { 0 };
+
+		// Allocates the whole ring up front, so this is only ever called from the UI thread
+		EO_Deep(unsigned int count) : chunks(count) {
+			unsigned int offset = 0;
+			for (int level = 0; level < DEEP_LEVELS; level++) {
+				offsets[level] = offset;
+				offset += DEEP_CHUNK >> (2 * level + 2);
+			}
+		}
+
+		uint64_t capacity() {
+			return (uint64_t)chunks.size() * DEEP_CHUNK;
+		}
+
+		// The oldest sample that is safe to read. The chunk being written and the one after 
+		// it are left alone, so the engine can carry on while the UI is reading.
+		uint64_t oldest(uint64_t end) {
+			uint64_t start = (end / DEEP_CHUNK + 2) * DEEP_CHUNK;
+			return (start > capacity()) ? start - capacity() : 0;
+		}
+
+		// Engine thread
+		void add(float value0, float value1) {
+			uint64_t n = written.load(std::memory_order_relaxed);
+			EO_DeepChunk &chunk = chunks[(n / DEEP_CHUNK) % chunks.size()];
+			unsigned int sample = n % DEEP_CHUNK;
+			float values[2] = { value0, value1 };
+			for (int i = 0; i < 2; i++) {
+				chunk.raw[i][sample] = values[i];
+				float low = values[i];
+				float high = values[i];
+				// Each level takes in an entry from the level below once it is complete
+				for (int level = 0; level < DEEP_LEVELS; level++) {
+					unsigned int quarter = (sample >> (2 * level)) & 3;
+					float *entry = chunk.pyramid[i] + (offsets[level] + (sample >> (2 * level + 2))) * 2;
+					if (quarter) {
+						entry[0] = std::min(entry[0], low);
+						entry[1] = std::max(entry[1], high);
+					}
+					else {
+						entry[0] = low;
+						entry[1] = high;
+					}
+					if (quarter != 3)
+						break;
+					low = entry[0];
+					high = entry[1];
+				}
+			}
+			written.store(n + 1, std::memory_order_release);
+		}
+
+		// UI thread. The lowest and highest value from sample start up to sample end, 
+		// using the biggest pyramid entries that fit.
+		void span(int input, uint64_t start, uint64_t end, float &low, float &high) {
+			low = INFINITY;
+			high = -INFINITY;
+			while (start < end) {
+				EO_DeepChunk &chunk = chunks[(start / DEEP_CHUNK) % chunks.size()];
+				unsigned int sample = start % DEEP_CHUNK;
+				int level = -1;
+				while (level + 1 < DEEP_LEVELS) {
+					unsigned int size = 4u << (2 * (level + 1));
+					if ((sample & (size - 1)) || (start + size > end))
+						break;
+					level++;
+				}
+				if (level < 0) {
+					low = std::min(low, chunk.raw[input][sample]);
+					high = std::max(high, chunk.raw[input][sample]);
+					start++;
+					continue;
+				}
+				float *entry = chunk.pyramid[input] + (offsets[level] + (sample >> (2 * level + 2))) * 2;
+				low = std::min(low, entry[0]);
+				high = std::max(high, entry[1]);
+				start += 4u << (2 * level);
+			}
+		}
+	};
+} // end namespace
 
 struct EO_102 : Module {
 	enum ParamIds {
@@ -40,11 +157,16 @@ struct EO_102 : Module {
 		NUM_LIGHTS
 	};
 	
-	float buffer[2][BUFFER_SIZE] = {};
+	// The sweep is captured into frames.write() and published when it completes, and, 
+	// unless the spectrum is being shown, about 60 times a second while it is in progress 
+	// so that slow sweeps still draw as they go.
+	TripleBuffer<EO_Frame> frames;
 	int bufferIndex = 0;
 	float frameIndex = 0;
+	int publishIndex = 0;
+	int envelopeColumn = -1;
 	
-	float preBuffer[2][PRE_SIZE] = {};
+	float_4 preBuffer[2][MAX_BLOCKS][PRE_SIZE] = {};
 	int preBufferIndex = 0;
 	float preFrameIndex = 0;
 	int preCount = 0;
@@ -52,8 +174,28 @@ struct EO_102 : Module {
 	dsp::SchmittTrigger trigger;
 	dsp::PulseGenerator triggerLight;
 	float runMode;
-	int traceMode[2];
+	int traceMode[2] = {};
 	int traceStep;	
+	float sweepRate = 44100.0f;
+	int channels[2] = { 1, 1 };
+	bool poly = false;
+	bool stack = false;
+	// Spectrum analyser settings, used by the display
+	bool spectrum = false;
+	int window = 1;
+	int average = 0;
+
+	// Deep memory is allocated and freed on the UI thread. The UI requests a new ring and 
+	// the engine shows which one it is using; a ring that has been replaced is freed once 
+	// the engine has stopped using it.
+	std::atomic<EO_Deep *> deepRequest { nullptr };
+	std::atomic<EO_Deep *> deepActive { nullptr };
+	EO_Deep *deep = nullptr;
+	std::vector<EO_Deep *> deepRetired;
+	unsigned int deepChunks = 0;
+	// The deep memory view: samples per display column, and samples back from the newest
+	float deepZoom = 256.0f;
+	float deepPan = 0.0f;
 
 	EO_102() : Module() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -73,16 +215,143 @@ struct EO_102 : Module {
 		configParam(PARAM_COLORS, 0.0f, 1.0f, 0.0f, "Match cable colors");
 	}
 
+	~EO_102() {
+		delete deepRequest.load();
+		for (EO_Deep *retired : deepRetired)
+			delete retired;
+	}
+
+	json_t *dataToJson() override {
+		json_t *rootJ = json_object();
+		json_object_set_new(rootJ, "poly", json_boolean(poly));
+		json_object_set_new(rootJ, "stack", json_boolean(stack));
+		json_object_set_new(rootJ, "deep", json_integer(deepChunks));
+		json_object_set_new(rootJ, "spectrum", json_boolean(spectrum));
+		json_object_set_new(rootJ, "window", json_integer(window));
+		json_object_set_new(rootJ, "average", json_integer(average));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override {
+		json_t *polyJ = json_object_get(rootJ, "poly");
+		if (polyJ)
+			poly = json_is_true(polyJ);
+		json_t *stackJ = json_object_get(rootJ, "stack");
+		if (stackJ)
+			stack = json_is_true(stackJ);
+		json_t *spectrumJ = json_object_get(rootJ, "spectrum");
+		if (spectrumJ)
+			spectrum = json_is_true(spectrumJ);
+		json_t *windowJ = json_object_get(rootJ, "window");
+		if (windowJ)
+			window = clamp((int)json_integer_value(windowJ), 0, 2);
+		json_t *averageJ = json_object_get(rootJ, "average");
+		if (averageJ)
+			average = clamp((int)json_integer_value(averageJ), 0, 2);
+		json_t *deepJ = json_object_get(rootJ, "deep");
+		if (deepJ) {
+			// Only the sizes on the menu, so a damaged patch can't ask for a huge recording
+			json_int_t chunks = json_integer_value(deepJ);
+			if (chunks == 0 || chunks == 16 || chunks == 64 || chunks == 256)
+				setDeep(chunks);
+		}
+	}
+
+	// UI thread
+	void setDeep(unsigned int chunks) {
+		if (chunks == deepChunks)
+			return;
+		deepChunks = chunks;
+		EO_Deep *old = deepRequest.exchange(chunks ? new EO_Deep(chunks) : nullptr);
+		if (old)
+			deepRetired.push_back(old);
+		deepPan = 0.0f;
+		deepZoom = clamp(deepZoom, 1.0f, 1.0f * chunks * DEEP_CHUNK / DISPLAY_COLUMNS);
+	}
+
+	// UI thread
+	void freeDeep() {
+		EO_Deep *active = deepActive.load();
+		for (std::vector<EO_Deep *>::iterator it = deepRetired.begin(); it != deepRetired.end(); ) {
+			if (*it == active) {
+				it++;
+				continue;
+			}
+			delete *it;
+			it = deepRetired.erase(it);
+		}
+	}
+
+	int blocks(int i) {
+		return (channels[i] + 3) / 4;
+	}
+
+	void publishFrame() {
+		EO_Frame &frame = frames.write();
+		for (int i = 0; i < 2; i++) {
+			frame.channels[i] = channels[i];
+			frame.traceMode[i] = traceMode[i];
+		}
+		frame.preCount = preCount;
+		frame.sampleRate = sweepRate;
+		frame.complete = (bufferIndex >= BUFFER_SIZE);
+		frames.publish();
+		// Carry on from where we were, so the next frame published is still a whole one. 
+		// Only the blocks in use are copied, so mono capture doesn't pay for poly.
+		EO_Frame &next = frames.write();
+		for (int i = 0; i < 2; i++) {
+			for (int b = 0; b < blocks(i); b++) {
+				memcpy(next.buffer[i][b], frame.buffer[i][b], sizeof(frame.buffer[i][b]));
+				memcpy(next.low[i][b], frame.low[i][b], sizeof(frame.low[i][b]));
+				memcpy(next.high[i][b], frame.high[i][b], sizeof(frame.high[i][b]));
+				memcpy(next.rising[i][b], frame.rising[i][b], sizeof(frame.rising[i][b]));
+			}
+		}
+		publishIndex = 0;
+	}
+
+	void addEnvelope(int i, int b, int column, bool newColumn, float_4 value) {
+		EO_Frame &frame = frames.write();
+		float_4 &low = frame.low[i][b][column];
+		float_4 &high = frame.high[i][b][column];
+		float_4 &rising = frame.rising[i][b][column];
+		if (newColumn) {
+			low = high = value;
+			rising = 1.0f;
+			return;
+		}
+		rising = simd::ifelse(value > high, 1.0f, simd::ifelse(value < low, 0.0f, rising));
+		high = simd::fmax(high, value);
+		low = simd::fmin(low, value);
+	}
+
 	void startFrame() {
 		triggerLight.trigger(0.1f);
 		frameIndex = 0;
+		envelopeColumn = -1;
 		preCount = (int)(params[PARAM_PRE].getValue() + 0.5f);
+		float_4 (*buffer)[MAX_BLOCKS][BUFFER_SIZE] = frames.write().buffer;
 		for (int i = 0; i < 2; i++) {
-			for (int s = 0; s < preCount; s++) {
-				buffer[i][s] = preBuffer[i][(preBufferIndex + (PRE_SIZE * 2) - preCount + s) % PRE_SIZE];
+			// Blocks that weren't being captured have nothing before the trigger
+			int captured = blocks(i);
+			channels[i] = poly ? clamp(inputs[INPUT_1 + i].getChannels(), 1, 16) : 1;
+			for (int b = 0; b < blocks(i); b++) {
+				for (int s = 0; s < preCount; s++) {
+					buffer[i][b][s] = (b < captured) ? preBuffer[i][b][(preBufferIndex + (PRE_SIZE * 2) - preCount + s) % PRE_SIZE] : float_4(0.0f);
+				}
 			}
 			traceMode[i] = (int)(params[PARAM_MODE_1 + i].getValue() + 0.5f);
 		}
+		// Only the kept samples are left from before the trigger
+		for (int s = 0; s < preCount; s++) {
+			int column = s * DISPLAY_COLUMNS / BUFFER_SIZE;
+			for (int i = 0; i < 2; i++) {
+				for (int b = 0; b < blocks(i); b++) {
+					addEnvelope(i, b, column, column != envelopeColumn, buffer[i][b][s]);
+				}
+			}
+			envelopeColumn = column;
+		}
 		bufferIndex = preCount;
 		traceStep = 1;
 	}
@@ -97,22 +366,45 @@ struct EO_102 : Module {
 		// Compute time
 		float deltaTime = powf(2.0f, params[PARAM_TIME].getValue());
 		int frameCount = (int)ceilf(deltaTime * args.sampleRate);
+		sweepRate = args.sampleRate / frameCount;
 		lights[LIGHT_TRIGGER].setBrightness(triggerLight.process(args.sampleTime));
+
+		EO_Deep *requested = deepRequest.load();
+		if (requested != deep) {
+			// Show the UI which ring we are about to use, then check it wasn't replaced 
+			// in the meantime, in which case it may already have been freed
+			deepActive.store(requested);
+			deep = nullptr;
+			if (deepRequest.load() != requested)
+				return;
+			deep = requested;
+		}
+		if (deep) {
+			// Record until the RUN button is turned off
+			if (params[PARAM_RUN].getValue() > 0.5f)
+				deep->add(inputs[INPUT_1].getVoltage(), inputs[INPUT_2].getVoltage());
+			return;
+		}
 		
 		// Add frame to preBuffer
 		for (int i = 0; i < 2; i++) {
 			if (params[PARAM_MODE_1 + i].getValue() > 0.5f) {
-				if (traceStep) {
-					preBuffer[i][preBufferIndex] = fabs(inputs[INPUT_1 + i].getVoltage());
+				for (int b = 0; b < blocks(i); b++) {
+					float_4 value = simd::fabs(inputs[INPUT_1 + i].getVoltageSimd<float_4>(b * 4));
+					if (traceStep) {
+						preBuffer[i][b][preBufferIndex] = value;
+					}
+					preBuffer[i][b][preBufferIndex] = simd::fmax(preBuffer[i][b][preBufferIndex], value);
 				}
-				preBuffer[i][preBufferIndex] = std::max(preBuffer[i][preBufferIndex], (float)fabs(inputs[INPUT_1 + i].getVoltage()));
 			}
 		}
 		if (++preFrameIndex >= frameCount) {
 			preFrameIndex = 0;
 			for (int i = 0; i < 2; i++) {
 				if (params[PARAM_MODE_1 + i].getValue() < 0.5f) {
-					preBuffer[i][preBufferIndex] = inputs[INPUT_1 + i].getVoltage();
+					for (int b = 0; b < blocks(i); b++) {
+						preBuffer[i][b][preBufferIndex] = inputs[INPUT_1 + i].getVoltageSimd<float_4>(b * 4);
+					}
 				}
 			}
 			preBufferIndex++;
@@ -123,25 +415,40 @@ struct EO_102 : Module {
 	
 		// Add frame to buffer
 		if (bufferIndex < BUFFER_SIZE) {
+			float_4 (*buffer)[MAX_BLOCKS][BUFFER_SIZE] = frames.write().buffer;
+			int column = bufferIndex * DISPLAY_COLUMNS / BUFFER_SIZE;
+			bool newColumn = (column != envelopeColumn);
 			for (int i = 0; i < 2; i++) {
-				if (traceMode[i]) {
-					if (traceStep) {
-						buffer[i][bufferIndex] = fabs(inputs[INPUT_1 + i].getVoltage());
+				for (int b = 0; b < blocks(i); b++) {
+					float_4 value = inputs[INPUT_1 + i].getVoltageSimd<float_4>(b * 4);
+					if (traceMode[i]) {
+						value = simd::fabs(value);
+						if (traceStep) {
+							buffer[i][b][bufferIndex] = value;
+						}
+						buffer[i][b][bufferIndex] = simd::fmax(buffer[i][b][bufferIndex], value);
 					}
-					buffer[i][bufferIndex] = std::max(buffer[i][bufferIndex], (float)fabs(inputs[INPUT_1 + i].getVoltage()));
+					addEnvelope(i, b, column, newColumn, value);
 				}
 			}
+			envelopeColumn = column;
 			traceStep = 0;
 			if (++frameIndex >= frameCount) {
 				frameIndex = 0;
 				for (int i = 0; i < 2; i++) {
 					if (!traceMode[i]) {
-						buffer[i][bufferIndex] = inputs[INPUT_1 + i].getVoltage();
+						for (int b = 0; b < blocks(i); b++) {
+							buffer[i][b][bufferIndex] = inputs[INPUT_1 + i].getVoltageSimd<float_4>(b * 4);
+						}
 					}
 				}
 				bufferIndex++;
 				traceStep = 1;
 			}
+			// The spectrum analyser needs every complete sweep, which a partial one published 
+			// after it could replace before the display has read it
+			if (bufferIndex >= BUFFER_SIZE || (!spectrum && ++publishIndex >= args.sampleRate / 60))
+				publishFrame();
 		}
 	
 		int triggerInput = INPUT_1;
@@ -178,32 +485,122 @@ struct EO_102 : Module {
 	}
 };
 	
+#ifndef SUBMARINE_HEADLESS
 namespace {
 
+	// The spectrum of channel 0 of each input, taken from each complete sweep. This runs 
+	// on the UI thread, so it costs the engine nothing.
+	struct EO_Spectrum {
+		dsp::RealFFT fft { BUFFER_SIZE };
+		alignas(16) float samples[BUFFER_SIZE];
+		alignas(16) float bins[BUFFER_SIZE * 2];
+		float windows[3][BUFFER_SIZE];
+		float windowGain[3];
+		// Averaged power of each bin; a sine of amplitude A gives A^2 in its bin
+		float power[2][BUFFER_SIZE / 2] = {};
+		float sampleRate[2] = {};
+
+		EO_Spectrum() {
+			for (int w = 0; w < 3; w++) {
+				for (int i = 0; i < BUFFER_SIZE; i++)
+					windows[w][i] = 1.0f;
+			}
+			dsp::hannWindow(windows[1], BUFFER_SIZE);
+			dsp::blackmanHarrisWindow(windows[2], BUFFER_SIZE);
+			for (int w = 0; w < 3; w++) {
+				windowGain[w] = 0.0f;
+				for (int i = 0; i < BUFFER_SIZE; i++)
+					windowGain[w] += windows[w][i];
+			}
+		}
+
+		void analyse(const EO_Frame &frame, int input, int window, int average) {
+			for (int i = 0; i < BUFFER_SIZE; i++)
+				samples[i] = frame.buffer[input][0][i][0] * windows[window][i];
+			fft.rfft(samples, bins);
+			// Start averaging again if the time base has changed
+			float amount = (average == 2) ? 0.0625f : (average == 1) ? 0.25f : 1.0f;
+			if (frame.sampleRate != sampleRate[input])
+				amount = 1.0f;
+			sampleRate[input] = frame.sampleRate;
+			float scale = 2.0f / windowGain[window];
+			scale *= scale;
+			for (int k = 1; k < BUFFER_SIZE / 2; k++) {
+				float p = (bins[2 * k] * bins[2 * k] + bins[2 * k + 1] * bins[2 * k + 1]) * scale;
+				power[input][k] += (p - power[input][k]) * amount;
+			}
+		}
+
+		static float decibels(float p) {
+			return 10.0f * log10f(p + 1e-20f);
+		}
+	};
+
 	struct EO_Display : LightWidget {
 		EO_102 *module;
 		PortWidget *ports[2];
+		EO_Spectrum spectrum;
 	
-		void drawTrace(NVGcontext *vg, float *values, float offset, float scale, NVGcolor col, int mode) {
-			if (!values)
-				return;
+		void drawTrace(NVGcontext *vg, const EO_Frame &frame, int input, int channel, Rect b, float offset, float scale, NVGcolor col) {
+			const float *low = &frame.low[input][channel / 4][0][channel % 4];
+			const float *high = &frame.high[input][channel / 4][0][channel % 4];
+			const float *rising = &frame.rising[input][channel / 4][0][channel % 4];
+			drawEnvelope(vg, b, low, high, rising, 4, 0, frame.traceMode[input], offset, scale, col);
+		}
+
+		void drawDeepTrace(NVGcontext *vg, EO_Deep *deep, uint64_t end, int input, float offset, float scale, NVGcolor col) {
+			float low[DISPLAY_COLUMNS];
+			float high[DISPLAY_COLUMNS];
+			int mode = (module->params[EO_102::PARAM_MODE_1 + input].getValue() > 0.5f);
+			uint64_t oldest = deep->oldest(end);
+			int first = DISPLAY_COLUMNS;
+			for (int i = DISPLAY_COLUMNS - 1; i >= 0; i--) {
+				double start = (double)end - (DISPLAY_COLUMNS - i) * module->deepZoom;
+				if (start < oldest)
+					break;
+				deep->span(input, (uint64_t)start, (uint64_t)(start + module->deepZoom), low[i], high[i]);
+				if (mode) {
+					high[i] = low[i] = std::max(fabsf(low[i]), fabsf(high[i]));
+				}
+				first = i;
+			}
+			if (first < DISPLAY_COLUMNS)
+				drawEnvelope(vg, Rect(Vec(0, 0), box.size), low, high, NULL, 1, first, mode, offset, scale, col);
+		}
+
+		// At most two vertices for each pixel column, however many samples it covers. 
+		// Columns from first onwards are drawn from the low and high values, which are 
+		// stride floats apart; the trace is drawn within b, which is the whole display 
+		// unless traces are stacked.
+		void drawEnvelope(NVGcontext *vg, Rect b, const float *low, const float *high, const float *rising, int stride, int first, int mode, float offset, float scale, NVGcolor col) {
 			float scaling = powf(2.0, scale);
 			nvgSave(vg);
-			Rect b = Rect(Vec(0, 0), box.size);
 			nvgScissor(vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
 			nvgBeginPath(vg);
-			for (int i = 0; i < BUFFER_SIZE; i++) {
+			for (int i = first; i < DISPLAY_COLUMNS; i++) {
 				float x, y;
-				x = (float)i / (BUFFER_SIZE - 1) * b.size.x;
-				y = ((values[i] * scaling + offset ) / 20.0f - 0.8f) * -b.size.y;
-				if (i == 0)
+				float start = high[i * stride];
+				float last = high[i * stride];
+				if (!mode) {
+					if (!rising || rising[i * stride] > 0.5f)
+						start = low[i * stride];
+					else
+						last = low[i * stride];
+				}
+				x = (float)i / (DISPLAY_COLUMNS - 1) * b.size.x;
+				y = b.pos.y + ((start * scaling + offset ) / 20.0f - 0.8f) * -b.size.y;
+				if (i == first)
 					nvgMoveTo(vg, x, y);
 				else
 					nvgLineTo(vg, x, y);
+				if (last != start) {
+					y = b.pos.y + ((last * scaling + offset ) / 20.0f - 0.8f) * -b.size.y;
+					nvgLineTo(vg, x, y);
+				}
 			} 
 			if (mode) {
-				nvgLineTo(vg, b.size.x, (offset / 20.0f - 0.8f) * -b.size.y);
-				nvgLineTo(vg, 0, (offset / 20.0f - 0.8f) * -b.size.y);
+				nvgLineTo(vg, b.size.x, b.pos.y + (offset / 20.0f - 0.8f) * -b.size.y);
+				nvgLineTo(vg, (float)first / (DISPLAY_COLUMNS - 1) * b.size.x, b.pos.y + (offset / 20.0f - 0.8f) * -b.size.y);
 				nvgClosePath(vg);
 				nvgFillColor(vg, col);
 				nvgGlobalCompositeOperation(vg, NVG_LIGHTER);
@@ -320,6 +717,17 @@ namespace {
 				drawEasterEgg(args.vg);
 				return;
 			}
+			EO_Deep *deep = module->deepRequest.load();
+			if (deep) {
+				drawDeep(args.vg, deep);
+				return;
+			}
+			bool fresh = module->frames.update();
+			const EO_Frame &frame = module->frames.read();
+			if (module->spectrum) {
+				drawSpectrum(args.vg, frame, fresh && frame.complete);
+				return;
+			}
 			NVGcolor col = SUBLIGHTBLUETRANS;
 			for (int i = 0; i < 2; i++) {
 				if (module->inputs[EO_102::INPUT_1 + i].isConnected()) {
@@ -327,7 +735,16 @@ namespace {
 						col = APP->scene->rack->getTopCable(ports[i])->color;
 						col.a = 1.0f;
 					}
-					drawTrace(args.vg, module->buffer[i], module->params[EO_102::PARAM_OFFSET_1 + i].getValue(), module->params[EO_102::PARAM_SCALE_1 + i].getValue(), col, module->traceMode[i]); 
+					// Poly channels are either drawn over each other or stacked in rows
+					int channels = frame.channels[i];
+					for (int c = 0; c < channels; c++) {
+						Rect b = Rect(Vec(0, 0), box.size);
+						if (module->stack) {
+							b.size.y /= channels;
+							b.pos.y = b.size.y * c;
+						}
+						drawTrace(args.vg, frame, i, c, b, module->params[EO_102::PARAM_OFFSET_1 + i].getValue(), module->params[EO_102::PARAM_SCALE_1 + i].getValue(), col);
+					} 
 				}
 				col = SUBLIGHTREDTRANS;
 			}
@@ -339,7 +756,172 @@ namespace {
 			else
 				drawTrigger(args.vg, module->params[EO_102::PARAM_TRIGGER].getValue(), module->params[EO_102::PARAM_OFFSET_1].getValue(), module->params[EO_102::PARAM_SCALE_1].getValue());
 			drawMask(args.vg, clamp(module->params[EO_102::PARAM_PRE].getValue(), 0.0f, 1.0f * PRE_SIZE) / BUFFER_SIZE);
-			drawPre(args.vg, 1.0f * module->preCount / BUFFER_SIZE);
+			drawPre(args.vg, 1.0f * frame.preCount / BUFFER_SIZE);
+		}
+
+		void drawDeep(NVGcontext *vg, EO_Deep *deep) {
+			uint64_t written = deep->written.load(std::memory_order_acquire);
+			float maxPan = std::max(0.0f, (float)(written - deep->oldest(written)) - module->deepZoom * DISPLAY_COLUMNS);
+			module->deepPan = clamp(module->deepPan, 0.0f, maxPan);
+			uint64_t end = written - (uint64_t)module->deepPan;
+			NVGcolor col = SUBLIGHTBLUETRANS;
+			for (int i = 0; i < 2; i++) {
+				if (module->inputs[EO_102::INPUT_1 + i].isConnected()) {
+					if (module->params[EO_102::PARAM_COLORS].getValue()) {
+						col = APP->scene->rack->getTopCable(ports[i])->color;
+						col.a = 1.0f;
+					}
+					drawDeepTrace(vg, deep, end, i, module->params[EO_102::PARAM_OFFSET_1 + i].getValue(), module->params[EO_102::PARAM_SCALE_1 + i].getValue(), col);
+				}
+				col = SUBLIGHTREDTRANS;
+			}
+			drawIndex(vg, clamp(module->params[EO_102::PARAM_INDEX_1].getValue(), 0.0f, 1.0f));
+			drawIndex(vg, clamp(module->params[EO_102::PARAM_INDEX_2].getValue(), 0.0f, 1.0f));
+			drawIndexV(vg, clamp(module->params[EO_102::PARAM_INDEX_3].getValue(), 0.0f, 1.0f));
+		}
+
+		// Frequency runs from the first bin to half the sample rate on a log scale, and 
+		// power from +20dB (a 10V sine) down to -100dB.
+		float spectrumX(float frequency, float rate) {
+			float low = rate / BUFFER_SIZE;
+			return logf(frequency / low) / logf(BUFFER_SIZE / 2.0f) * box.size.x;
+		}
+		float spectrumY(float decibels) {
+			return (20.0f - decibels) / 120.0f * box.size.y;
+		}
+
+		void drawSpectrum(NVGcontext *vg, const EO_Frame &frame, bool analyse) {
+			float rate = frame.sampleRate;
+			if (!(rate > 0.0f))
+				return;
+			nvgSave(vg);
+			nvgScissor(vg, 0, 0, box.size.x, box.size.y);
+			// Grid
+			nvgStrokeColor(vg, nvgRGBA(0xff, 0xff, 0xff, 0x20));
+			nvgStrokeWidth(vg, 1.0f);
+			nvgBeginPath(vg);
+			for (float db = 0.0f; db > -100.0f; db -= 20.0f) {
+				nvgMoveTo(vg, 0, spectrumY(db));
+				nvgLineTo(vg, box.size.x, spectrumY(db));
+			}
+			for (float f = 10.0f; f < rate / 2; f *= 10.0f) {
+				if (f > rate / BUFFER_SIZE) {
+					nvgMoveTo(vg, spectrumX(f, rate), 0);
+					nvgLineTo(vg, spectrumX(f, rate), box.size.y);
+				}
+			}
+			nvgStroke(vg);
+			nvgFontSize(vg, 10);
+			nvgFontFaceId(vg, gScheme.font()->handle);
+			nvgFillColor(vg, nvgRGBA(0xff, 0xff, 0xff, 0x80));
+			nvgTextAlign(vg, NVG_ALIGN_LEFT | NVG_ALIGN_BOTTOM);
+			for (float f = 10.0f; f < rate / 2; f *= 10.0f) {
+				if (f > rate / BUFFER_SIZE)
+					nvgText(vg, spectrumX(f, rate) + 2, box.size.y - 2, frequencyText(f).c_str(), NULL);
+			}
+			NVGcolor col = SUBLIGHTBLUETRANS;
+			for (int i = 0; i < 2; i++) {
+				if (module->inputs[EO_102::INPUT_1 + i].isConnected()) {
+					if (module->params[EO_102::PARAM_COLORS].getValue()) {
+						col = APP->scene->rack->getTopCable(ports[i])->color;
+						col.a = 1.0f;
+					}
+					if (analyse)
+						spectrum.analyse(frame, i, module->window, module->average);
+					drawPower(vg, spectrum.power[i], rate, col);
+				}
+				col = SUBLIGHTREDTRANS;
+			}
+			nvgResetScissor(vg);
+			nvgRestore(vg);
+		}
+
+		void drawPower(NVGcontext *vg, const float *power, float rate, NVGcolor col) {
+			nvgBeginPath(vg);
+			for (int k = 1; k < BUFFER_SIZE / 2; k++) {
+				float x = spectrumX(k * rate / BUFFER_SIZE, rate);
+				float y = spectrumY(EO_Spectrum::decibels(power[k]));
+				if (k == 1)
+					nvgMoveTo(vg, x, y);
+				else
+					nvgLineTo(vg, x, y);
+			}
+			nvgStrokeColor(vg, col);
+			nvgLineCap(vg, NVG_ROUND);
+			nvgStrokeWidth(vg, 1.5f);
+			nvgGlobalCompositeOperation(vg, NVG_LIGHTER);
+			nvgStroke(vg);
+
+			// Mark the three biggest peaks above -80dB. The frequency is refined by fitting 
+			// a parabola through the peak bin and its neighbours.
+			int peaks[3] = { 0, 0, 0 };
+			for (int k = 2; k < BUFFER_SIZE / 2 - 1; k++) {
+				if (power[k] <= power[k - 1] || power[k] < power[k + 1] || EO_Spectrum::decibels(power[k]) < -80.0f)
+					continue;
+				for (int p = 0; p < 3; p++) {
+					if (!peaks[p] || power[k] > power[peaks[p]]) {
+						for (int q = 2; q > p; q--)
+							peaks[q] = peaks[q - 1];
+						peaks[p] = k;
+						break;
+					}
+				}
+			}
+			nvgFillColor(vg, col);
+			nvgTextAlign(vg, NVG_ALIGN_CENTER | NVG_ALIGN_BOTTOM);
+			for (int p = 0; p < 3; p++) {
+				int k = peaks[p];
+				if (!k)
+					break;
+				float a = EO_Spectrum::decibels(power[k - 1]);
+				float b = EO_Spectrum::decibels(power[k]);
+				float c = EO_Spectrum::decibels(power[k + 1]);
+				float offset = 0.0f;
+				if (a - 2.0f * b + c < 0.0f)
+					offset = 0.5f * (a - c) / (a - 2.0f * b + c);
+				float frequency = (k + offset) * rate / BUFFER_SIZE;
+				float x = spectrumX(frequency, rate);
+				float y = spectrumY(b);
+				nvgBeginPath(vg);
+				nvgMoveTo(vg, x, y - 2);
+				nvgLineTo(vg, x - 3, y - 7);
+				nvgLineTo(vg, x + 3, y - 7);
+				nvgClosePath(vg);
+				nvgFill(vg);
+				nvgText(vg, x, y - 8, frequencyText(frequency).c_str(), NULL);
+			}
+		}
+
+		std::string frequencyText(float frequency) {
+			if (frequency < 999.5f)
+				return string::f("%.0fHz", frequency);
+			return string::f("%.3gkHz", frequency / 1000.0f);
+		}
+
+		// In deep memory mode Ctrl + scroll zooms and dragging pans through the recording. 
+		// Scrolling without Ctrl is left to scroll the rack.
+		void onButton(const event::Button &e) override {
+			if (module && module->deepChunks && e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS)
+				e.consume(this);
+		}
+		void onDragMove(const event::DragMove &e) override {
+			if (module && module->deepChunks && e.button == GLFW_MOUSE_BUTTON_LEFT) {
+				e.consume(this);
+				module->deepPan += e.mouseDelta.x * module->deepZoom * DISPLAY_COLUMNS / box.size.x;
+			}
+		}
+		void onHoverScroll(const event::HoverScroll &e) override {
+			if ((APP->window->getMods() & RACK_MOD_MASK) != RACK_MOD_CTRL)
+				return;
+			if (module && module->deepChunks) {
+				e.consume(this);
+				float maxZoom = 1.0f * module->deepChunks * DEEP_CHUNK / DISPLAY_COLUMNS;
+				float zoom = clamp(module->deepZoom * powf(2.0f, -e.scrollDelta.y / 50.0f), 1.0f, maxZoom);
+				// Keep the sample under the mouse where it is
+				float columns = DISPLAY_COLUMNS - e.pos.x * DISPLAY_COLUMNS / box.size.x;
+				module->deepPan = std::max(0.0f, module->deepPan - columns * (zoom - module->deepZoom));
+				module->deepZoom = zoom;
+			}
 		}
 	};
 	
@@ -367,8 +949,9 @@ namespace {
 				return;
 			} 
 			float deltaTime = powf(2.0f, module->params[EO_102::PARAM_TIME].getValue());
-			int frameCount = (int)ceilf(deltaTime * APP->engine->getSampleRate());
-			frameCount *= BUFFER_SIZE;
+			float frameCount = ceilf(deltaTime * APP->engine->getSampleRate()) * BUFFER_SIZE;
+			if (module->deepChunks)
+				frameCount = module->deepZoom * DISPLAY_COLUMNS;
 			float width = (float)frameCount * fabs(module->params[EO_102::PARAM_INDEX_1].getValue() - module->params[EO_102::PARAM_INDEX_2].getValue()) / APP->engine->getSampleRate(); 
 			
 			if (width < 0.00000995f)
@@ -482,6 +1065,12 @@ struct EO102 : SchemeModuleWidget {
 		addParam(createParamCentered<MedKnob<LightKnob>>(Vec(332, 320), module, EO_102::PARAM_INDEX_2));
 		addParam(createParamCentered<MedKnob<LightKnob>>(Vec(376, 320), module, EO_102::PARAM_INDEX_3));
 	}
+	void step() override {
+		EO_102 *eoModule = dynamic_cast<EO_102 *>(module);
+		if (eoModule)
+			eoModule->freeDeep();
+		SchemeModuleWidget::step();
+	}
 	void appendContextMenu(Menu *menu) override {
 		if (!module)
 			return;
@@ -495,6 +1084,89 @@ struct EO102 : SchemeModuleWidget {
 			module->params[EO_102::PARAM_COLORS].setValue(!val);
 		};
 		menu->addChild(vmi);
+		EO_102 *eoModule = dynamic_cast<EO_102 *>(module);
+		if (eoModule) {
+			EventWidgetMenuItem *dmi = createMenuItem<EventWidgetMenuItem>("Deep Memory");
+			dmi->rightText = SUBMENU;
+			dmi->childMenuHandler = [=]() {
+				Menu *menu = new Menu();
+				const char *labels[] = { "Off", "1M Samples", "4M Samples", "16M Samples" };
+				const unsigned int chunks[] = { 0, 16, 64, 256 };
+				for (int i = 0; i < 4; i++) {
+					unsigned int count = chunks[i];
+					EventWidgetMenuItem *cmi = createMenuItem<EventWidgetMenuItem>(labels[i]);
+					cmi->stepHandler = [=]() {
+						cmi->rightText = CHECKMARK(eoModule->deepChunks == count);
+					};
+					cmi->clickHandler = [=]() {
+						eoModule->setDeep(count);
+					};
+					menu->addChild(cmi);
+				}
+				return menu;
+			};
+			menu->addChild(dmi);
+			EventWidgetMenuItem *pmi = createMenuItem<EventWidgetMenuItem>("Polyphonic Capture");
+			pmi->stepHandler = [=]() {
+				pmi->rightText = CHECKMARK(eoModule->poly);
+			};
+			pmi->clickHandler = [=]() {
+				eoModule->poly = !eoModule->poly;
+			};
+			menu->addChild(pmi);
+			EventWidgetMenuItem *smi = createMenuItem<EventWidgetMenuItem>("Stack Polyphonic Traces");
+			smi->stepHandler = [=]() {
+				smi->rightText = CHECKMARK(eoModule->stack);
+			};
+			smi->clickHandler = [=]() {
+				eoModule->stack = !eoModule->stack;
+			};
+			menu->addChild(smi);
+			EventWidgetMenuItem *fmi = createMenuItem<EventWidgetMenuItem>("Spectrum Analyser");
+			fmi->stepHandler = [=]() {
+				fmi->rightText = CHECKMARK(eoModule->spectrum);
+			};
+			fmi->clickHandler = [=]() {
+				eoModule->spectrum = !eoModule->spectrum;
+			};
+			menu->addChild(fmi);
+			EventWidgetMenuItem *wmi = createMenuItem<EventWidgetMenuItem>("Spectrum Window");
+			wmi->rightText = SUBMENU;
+			wmi->childMenuHandler = [=]() {
+				Menu *menu = new Menu();
+				const char *labels[] = { "Rectangular", "Hann", "Blackman-Harris" };
+				for (int i = 0; i < 3; i++) {
+					EventWidgetMenuItem *cmi = createMenuItem<EventWidgetMenuItem>(labels[i]);
+					cmi->stepHandler = [=]() {
+						cmi->rightText = CHECKMARK(eoModule->window == i);
+					};
+					cmi->clickHandler = [=]() {
+						eoModule->window = i;
+					};
+					menu->addChild(cmi);
+				}
+				return menu;
+			};
+			menu->addChild(wmi);
+			EventWidgetMenuItem *ami = createMenuItem<EventWidgetMenuItem>("Spectrum Averaging");
+			ami->rightText = SUBMENU;
+			ami->childMenuHandler = [=]() {
+				Menu *menu = new Menu();
+				const char *labels[] = { "Off", "4 Sweeps", "16 Sweeps" };
+				for (int i = 0; i < 3; i++) {
+					EventWidgetMenuItem *cmi = createMenuItem<EventWidgetMenuItem>(labels[i]);
+					cmi->stepHandler = [=]() {
+						cmi->rightText = CHECKMARK(eoModule->average == i);
+					};
+					cmi->clickHandler = [=]() {
+						eoModule->average = i;
+					};
+					menu->addChild(cmi);
+				}
+				return menu;
+			};
+			menu->addChild(ami);
+		}
 	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		drawBase(vg, "EO-102");
@@ -545,3 +1217,4 @@ struct EO102 : SchemeModuleWidget {
 };
 
 Model *modelEO102 = createModel<EO_102, EO102>("EO-102");
+#endif
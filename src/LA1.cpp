@@ -3,8 +3,33 @@
 /* Portions of this code derive from Fundamental/src/Scope.cpp - Copyright © 2016 by Andrew Belt */
 #include <string.h>
 #include "shared/DS.hpp"
+#include "shared/TripleBuffer.hpp"
 
+// A sweep is BUFFER_SIZE steps of the TIME knob long, but every sample in it is kept
 #define BUFFER_SIZE 512
+#define RUN_COUNT 262144
+#define TOGGLE_LEVELS 4
+#define DISPLAY_COLUMNS 256
+
+namespace {
+	// The state of every channel from start until the next run. Input i is in bits 
+	// 16 * (i % 4) upwards of state[i / 4], with channel n in the nth of those bits.
+	struct LA_Run {
+		uint64_t start;
+		uint64_t state[2];
+	};
+
+	// Where a sweep is in the run ring. captured is the sample after the last one 
+	// recorded so far, and runs the number of runs written by then.
+	struct LA_Sweep {
+		uint64_t start;
+		uint64_t trigger;
+		uint64_t end;
+		uint64_t captured;
+		uint64_t runs;
+		int channels[8];
+	};
+} // end namespace
 
 struct LA_108 : DS_Module {
 	enum ParamIds {
@@ -47,18 +72,35 @@ struct LA_108 : DS_Module {
 		NUM_LIGHTS
 	};
 	
-	float buffer[8][BUFFER_SIZE] = {};
-	int bufferIndex = 0;
+	// Only changes of state are recorded, as runs in a ring. Each level of toggles has, 
+	// for every 16^(l+1) runs, a mask of the channels that changed in any of them, so 
+	// the display can find the activity in any span from a few entries.
+	std::vector<LA_Run> runs;
+	std::vector<uint64_t> toggles[TOGGLE_LEVELS];
+	std::atomic<uint64_t> runCount { 0 };
+	uint64_t runState[2] = {};
+	uint64_t now = 0;
+	uint64_t recordStart = 0;
+	bool recording = false;
+
+	// The sweep in progress, published when it completes and about 60 times a second 
+	// while it is being captured
+	TripleBuffer<LA_Sweep> sweeps;
+	LA_Sweep sweep = {};
+	bool capturing = false;
+	int publishIndex = 0;
 	float frameIndex = 0;
-	
-	float preBuffer[8][32] = {};
-	int preBufferIndex = 0;
-	float preFrameIndex = 0;
-	int preCount = 0;
+	int channels[8] = {};
+	bool poly = false;
+	// The view: how far the display is zoomed into the sweep, and how far along it is
+	float zoom = 1.0f;
+	float pan = 0.0f;
 
 	DS_Schmitt trigger;
 
-	LA_108() : DS_Module() {
+	LA_108() : DS_Module(), runs(RUN_COUNT) {
+		for (int level = 0; level < TOGGLE_LEVELS; level++)
+			toggles[level].resize((RUN_COUNT >> (4 * level + 4)) * 2);
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 		configParam(PARAM_TRIGGER, 0.0f, 8.0f, 0.0f, "Trigger input", "", 0.f, 1.f, 1.f);
 		configParam(PARAM_EDGE, 0.0f, 1.0f, 0.0f, "Trigger on falling edge");
@@ -71,19 +113,80 @@ struct LA_108 : DS_Module {
 		configParam(PARAM_COLORS, 0.0f, 1.0f, 0.0f, "Match cable colors");
 	}
 
-	void startFrame() {
-		frameIndex = 0;
-		preCount = (int)(params[PARAM_PRE].getValue() + 0.5f);
-		if (preCount) {
-			for (int i = 0; i < 8; i++) {
-				for (int s = 0; s < preCount; s++) {
-					buffer[i][s] = preBuffer[i][(preBufferIndex + 64 - preCount + s) % 32];
+	json_t *dataToJson() override {
+		json_t *rootJ = DS_Module::dataToJson();
+		json_object_set_new(rootJ, "poly", json_boolean(poly));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override {
+		DS_Module::dataFromJson(rootJ);
+		json_t *polyJ = json_object_get(rootJ, "poly");
+		if (polyJ)
+			poly = json_is_true(polyJ);
+	}
+
+	// Threshold every channel at the midpoint of the digital voltage range, 4 at a time
+	void packState(uint64_t *state) {
+		float threshold = midpoint();
+		state[0] = state[1] = 0;
+		for (int i = 0; i < 8; i++) {
+			channels[i] = inputs[INPUT_1 + i].getChannels();
+			if (!poly)
+				channels[i] = std::min(channels[i], 1);
+			uint64_t bits = 0;
+			if (channels[i] == 1) {
+				bits = (inputs[INPUT_1 + i].getVoltage() > threshold);
+			}
+			else {
+				for (int c = 0; c < channels[i]; c += 4) {
+					float_4 v = inputs[INPUT_1 + i].getVoltageSimd<float_4>(c);
+					bits |= (uint64_t)_mm_movemask_ps((v > threshold).v) << c;
 				}
+				bits &= (1 << channels[i]) - 1;
+			}
+			state[i / 4] |= bits << (16 * (i % 4));
+		}
+	}
+
+	void addRun(uint64_t *state) {
+		uint64_t n = runCount.load(std::memory_order_relaxed);
+		LA_Run &run = runs[n % RUN_COUNT];
+		run.start = now;
+		for (int j = 0; j < 2; j++) {
+			uint64_t changed = state[j] ^ runState[j];
+			run.state[j] = runState[j] = state[j];
+			for (int level = 0; level < TOGGLE_LEVELS; level++) {
+				unsigned int shift = 4 * level + 4;
+				uint64_t &entry = toggles[level][((n >> shift) % (RUN_COUNT >> shift)) * 2 + j];
+				if (n & ((1 << shift) - 1))
+					entry |= changed;
+				else
+					entry = changed;
 			}
-			bufferIndex = preCount;
-			return;
 		}
-		bufferIndex = 0;
+		runCount.store(n + 1, std::memory_order_release);
+	}
+
+	void publishSweep() {
+		LA_Sweep &published = sweeps.write();
+		published = sweep;
+		published.captured = now;
+		published.runs = runCount.load(std::memory_order_relaxed);
+		sweeps.publish();
+		publishIndex = 0;
+	}
+
+	void startFrame(int frameCount) {
+		frameIndex = 0;
+		uint64_t pre = (uint64_t)((int)(params[PARAM_PRE].getValue() + 0.5f) * frameCount);
+		sweep.trigger = now;
+		// There may not be as much recorded before the trigger as was asked for
+		sweep.start = std::max(now - std::min(now, pre), recordStart);
+		sweep.end = sweep.start + (uint64_t)BUFFER_SIZE * frameCount;
+		for (int i = 0; i < 8; i++)
+			sweep.channels[i] = std::max(channels[i], 1);
+		capturing = true;
 	}
 
 	void process(const ProcessArgs &args) override {
@@ -93,24 +196,34 @@ struct LA_108 : DS_Module {
 		// Compute time
 		float deltaTime = powf(2.0f, params[PARAM_TIME].getValue());
 		int frameCount = (int)ceilf(deltaTime * args.sampleRate);
-		
-		// Add frame to preBuffer
-		if (++preFrameIndex >= frameCount) {
-			preFrameIndex = 0;
-			for (int i = 0; i < 8; i++)
-				preBuffer[i][preBufferIndex] = inputs[INPUT_1 + i].getVoltage();
-			preBufferIndex++;
-			if (preBufferIndex >= 32)
-				preBufferIndex = 0;
+
+		// Record while capturing and while waiting for a trigger, so there is something 
+		// before the trigger point; a one-shot sweep that has finished is left alone.
+		bool record = capturing || (params[PARAM_RUN].getValue() < 0.5f) || (params[PARAM_RESET].getValue() > 0.5f);
+		if (record) {
+			uint64_t state[2];
+			packState(state);
+			if (!recording) {
+				recording = true;
+				recordStart = now;
+				addRun(state);
+			}
+			else if ((state[0] != runState[0]) || (state[1] != runState[1])) {
+				addRun(state);
+			}
 		}
+		else {
+			recording = false;
+		}
+		now++;
 	
-		// Add frame to buffer
-		if (bufferIndex < BUFFER_SIZE) {
-			if (++frameIndex >= frameCount) {
-				frameIndex = 0;
-				for (int i = 0; i < 8; i++)
-					buffer[i][bufferIndex] = inputs[INPUT_1 + i].getVoltage();
-				bufferIndex++;
+		if (capturing) {
+			if (now >= sweep.end) {
+				capturing = false;
+				publishSweep();
+			}
+			else if (++publishIndex >= args.sampleRate / 60) {
+				publishSweep();
 			}
 		}
 	
@@ -118,17 +231,13 @@ struct LA_108 : DS_Module {
 		int edge = (params[PARAM_EDGE].getValue() > 0.5f);
 		
 		// Are we waiting on the next trigger?
-		if (bufferIndex >= BUFFER_SIZE) {
+		if (!capturing) {
 			// Trigger immediately if nothing connected to trigger input
 			if (!inputs[triggerInput].isConnected()) {
-				startFrame();
+				startFrame(frameCount);
 				return;
 			}
 	
-			// Reset the Schmitt trigger so we don't trigger immediately if the input is high
-			if (frameIndex == 0) {
-				//trigger.set(edge);
-			}
 			frameIndex++;
 	
 			float gate = inputs[triggerInput].getVoltage();
@@ -139,20 +248,20 @@ struct LA_108 : DS_Module {
 				// Reset if triggered
 				float holdTime = 0.1f;
 				if (triggered) {
-					startFrame();
+					startFrame(frameCount);
 					return;
 				}
 	
 				// Reset if we've waited too long
 				if (frameIndex >= args.sampleRate * holdTime) {
-					startFrame();
+					startFrame(frameCount);
 					return;
 				}
 			}
 			else {
 				if (params[PARAM_RESET].getValue() > 0.5f) {
 					if (triggered) {
-						startFrame();
+						startFrame(frameCount);
 						params[PARAM_RESET].setValue(0.0f);
 						return;
 					}
@@ -160,37 +269,172 @@ struct LA_108 : DS_Module {
 			}
 		}
 	}
+
+	// UI thread. Runs older than this may be overwritten while the display is reading them.
+	uint64_t oldestRun(uint64_t written) {
+		uint64_t margin = 16384;
+		return (written + margin > RUN_COUNT) ? written + margin - RUN_COUNT : 0;
+	}
+
+	// UI thread. One past the last run in first..last that starts at or before sample, so 
+	// first if there isn't one.
+	uint64_t findRun(uint64_t first, uint64_t last, uint64_t sample) {
+		uint64_t low = first;
+		uint64_t high = last;
+		while (low < high) {
+			uint64_t mid = low + (high - low) / 2;
+			if (runs[mid % RUN_COUNT].start <= sample)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		return low;
+	}
+
+	// UI thread. The channels that changed in runs first..last, using the biggest 
+	// toggle entries that fit.
+	void findToggles(uint64_t first, uint64_t last, uint64_t *changed) {
+		changed[0] = changed[1] = 0;
+		while (first < last) {
+			int level = -1;
+			while (level + 1 < TOGGLE_LEVELS) {
+				uint64_t size = (uint64_t)16 << (4 * (level + 1));
+				if ((first & (size - 1)) || (first + size > last))
+					break;
+				level++;
+			}
+			if (level < 0) {
+				const LA_Run &run = runs[first % RUN_COUNT];
+				const LA_Run &previous = runs[(first - 1) % RUN_COUNT];
+				changed[0] |= run.state[0] ^ previous.state[0];
+				changed[1] |= run.state[1] ^ previous.state[1];
+				first++;
+				continue;
+			}
+			unsigned int shift = 4 * level + 4;
+			const uint64_t *entry = &toggles[level][((first >> shift) % (RUN_COUNT >> shift)) * 2];
+			changed[0] |= entry[0];
+			changed[1] |= entry[1];
+			first += (uint64_t)1 << shift;
+		}
+	}
 };
 
+#ifndef SUBMARINE_HEADLESS
 namespace {	
 	struct LA_Display : LightWidget {
 		LA_108 *module;
 		PortWidget *ports[8];
+		// For each column, the state of every channel where it starts and ends, and which 
+		// channels changed anywhere within it
+		uint64_t startState[DISPLAY_COLUMNS][2];
+		uint64_t endState[DISPLAY_COLUMNS][2];
+		uint64_t changed[DISPLAY_COLUMNS][2];
+		float edge[DISPLAY_COLUMNS];
+		bool valid[DISPLAY_COLUMNS];
+		double viewLeft = 0;
+		double viewWidth = 1;
 	
-		void drawTrace(NVGcontext *vg, float *values, float offset, NVGcolor col) {
-			if (!values)
-				return;
+		// The part of the sweep that is in view, from the zoom and pan
+		void setView(const LA_Sweep &sweep) {
+			double span = sweep.end - sweep.start;
+			viewWidth = span / module->zoom;
+			viewLeft = sweep.start + module->pan * (span - viewWidth);
+		}
+
+		float sampleX(double sample) {
+			return (sample - viewLeft) / viewWidth * box.size.x;
+		}
+
+		void findColumns(const LA_Sweep &sweep) {
+			uint64_t written = module->runCount.load(std::memory_order_acquire);
+			uint64_t first = module->oldestRun(written);
+			uint64_t last = std::min(sweep.runs, written);
+			for (int c = 0; c < DISPLAY_COLUMNS; c++) {
+				valid[c] = false;
+				// The column holds samples s0 up to but not including s1, which may be none 
+				// at all when zoomed in, so that every sample is in exactly one column
+				uint64_t s0 = std::max((uint64_t)ceil(viewLeft + viewWidth * c / DISPLAY_COLUMNS), sweep.start);
+				uint64_t s1 = std::min((uint64_t)ceil(viewLeft + viewWidth * (c + 1) / DISPLAY_COLUMNS), sweep.captured);
+				if (s0 > sweep.captured || s1 <= sweep.start || first >= last)
+					continue;
+				s1 = std::max(s0, s1);
+				// Start from the state before the column, so an edge on its first sample is 
+				// counted in it
+				uint64_t r0 = module->findRun(first, last, (s0 > sweep.start) ? s0 - 1 : s0);
+				uint64_t r1 = (s1 > s0) ? module->findRun(first, last, s1 - 1) : r0;
+				if (r1 == first)
+					continue;
+				// If the start of the column has already been overwritten, start from the oldest run left
+				if (r0 == first)
+					r0++;
+				const LA_Run &run0 = module->runs[(r0 - 1) % RUN_COUNT];
+				const LA_Run &run1 = module->runs[(r1 - 1) % RUN_COUNT];
+				for (int j = 0; j < 2; j++) {
+					startState[c][j] = run0.state[j];
+					endState[c][j] = run1.state[j];
+				}
+				module->findToggles(r0, r1, changed[c]);
+				// A single change can be drawn where it actually happened
+				if (r1 == r0 + 1)
+					edge[c] = sampleX(run1.start);
+				else
+					edge[c] = (c + 0.5f) * box.size.x / DISPLAY_COLUMNS;
+				valid[c] = true;
+			}
+		}
+
+		// Draws one channel in the band from low up to high. The path only has vertices where 
+		// the channel changes, so a long sweep with little activity is cheap to draw.
+		void drawChannel(NVGcontext *vg, int word, uint64_t bit, float low, float high, NVGcolor col) {
+			float columnWidth = box.size.x / DISPLAY_COLUMNS;
+			bool drawing = false;
+			float y = low;
+			float x = 0;
+			nvgBeginPath(vg);
+			for (int c = 0; c < DISPLAY_COLUMNS; c++) {
+				if (!valid[c]) {
+					if (drawing)
+						nvgLineTo(vg, x, y);
+					drawing = false;
+					continue;
+				}
+				float y0 = (startState[c][word] & bit) ? high : low;
+				float y1 = (endState[c][word] & bit) ? high : low;
+				if (!drawing) {
+					nvgMoveTo(vg, c * columnWidth, y0);
+					drawing = true;
+				}
+				x = (c + 1) * columnWidth;
+				y = y1;
+				if (!(changed[c][word] & bit))
+					continue;
+				nvgLineTo(vg, edge[c], y0);
+				nvgLineTo(vg, edge[c], (y0 == low) ? high : low);
+				if (y1 == y0)
+					nvgLineTo(vg, edge[c], y0);
+			}
+			if (drawing)
+				nvgLineTo(vg, x, y);
+			nvgStrokeColor(vg, col);
+			nvgStroke(vg);
+		}
+
+		void drawTrace(NVGcontext *vg, int input, int channels, float offset, NVGcolor col) {
 			nvgSave(vg);
 			Rect b = Rect(Vec(0, 0), box.size);
 			nvgScissor(vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
-			nvgBeginPath(vg);
-			for (int i = 0; i < BUFFER_SIZE; i++) {
-				float x, y;
-				x = (float)i / (BUFFER_SIZE - 1) * b.size.x;
-				y = module->voltage0 -clamp(values[i], module->voltage0, module->voltage1);
-				y *= 29.0f / (module->voltage1 - module->voltage0);
-				y += offset;
-				if (i == 0)
-					nvgMoveTo(vg, x, y);
-				else
-					nvgLineTo(vg, x, y);
-			} 
-			nvgStrokeColor(vg, col);
 			nvgLineCap(vg, NVG_ROUND);
 			nvgMiterLimit(vg, 2.0f);
-			nvgStrokeWidth(vg, 1.5f);
+			nvgStrokeWidth(vg, (channels > 4) ? 1.0f : 1.5f);
 			nvgGlobalCompositeOperation(vg, NVG_LIGHTER);
-			nvgStroke(vg);
+			// Polyphonic inputs are stacked, one lane for each channel
+			float pitch = 29.0f / channels;
+			float height = (channels > 1) ? pitch * 0.75f : pitch;
+			for (int n = 0; n < channels; n++) {
+				float low = offset - 29.0f + (n + 1) * pitch;
+				drawChannel(vg, input / 4, (uint64_t)1 << (16 * (input % 4) + n), low, low - height, col);
+			}
 			nvgResetScissor(vg);
 			nvgRestore(vg);	
 		}
@@ -212,11 +456,8 @@ namespace {
 		}
 	
 		void drawPre(NVGcontext *vg, float value) {
-			if (value == 0.0f)
-				return;
 			Rect b = Rect(Vec(0, 0), box.size);
 			nvgScissor(vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
-			value = value * b.size.x;
 	
 			nvgStrokeColor(vg, nvgRGBA(0xff, 0x40, 0x40, 0x80));
 			{
@@ -229,17 +470,16 @@ namespace {
 			nvgResetScissor(vg);
 		}
 	
-		void drawMask(NVGcontext *vg, float value) {
-			if (value == 0.0f)
+		void drawMask(NVGcontext *vg, float left, float right) {
+			if (right <= left)
 				return;
 			Rect b = Rect(Vec(0, 0), box.size);
 			nvgScissor(vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
-			value = value * b.size.x;
 	
 			nvgFillColor(vg, nvgRGBA(0xff, 0x40, 0x40, 0x40));
 			{
 				nvgBeginPath(vg);
-				nvgRect(vg, 0, 0, value, b.size.y);
+				nvgRect(vg, left, 0, right - left, b.size.y);
 				nvgClosePath(vg);
 			}
 			nvgFill(vg);
@@ -271,16 +511,24 @@ namespace {
 				drawEasterEgg(args.vg);
 				return;
 			}
-			for (int i = 0; i < 8; i++) {
-				if (module->inputs[LA_108::INPUT_1 + i].isConnected()) {
-					NVGcolor col = getColor(i);
-					drawTrace(args.vg, module->buffer[i], 32.5f + 35 * i, col); 
+			module->sweeps.update();
+			const LA_Sweep &sweep = module->sweeps.read();
+			if (sweep.end > sweep.start) {
+				setView(sweep);
+				findColumns(sweep);
+				for (int i = 0; i < 8; i++) {
+					if (module->inputs[LA_108::INPUT_1 + i].isConnected()) {
+						NVGcolor col = getColor(i);
+						drawTrace(args.vg, i, sweep.channels[i], 32.5f + 35 * i, col); 
+					}
 				}
+				float pre = clamp(module->params[LA_108::PARAM_PRE].getValue(), 0.0f, 32.0f) / BUFFER_SIZE;
+				drawMask(args.vg, sampleX(sweep.start), sampleX(sweep.start + pre * (sweep.end - sweep.start)));
+				if (sweep.trigger > sweep.start)
+					drawPre(args.vg, sampleX(sweep.trigger));
 			}
 			drawIndex(args.vg, clamp(module->params[LA_108::PARAM_INDEX_1].getValue(), 0.0f, 1.0f));
 			drawIndex(args.vg, clamp(module->params[LA_108::PARAM_INDEX_2].getValue(), 0.0f, 1.0f));
-			drawMask(args.vg, clamp(module->params[LA_108::PARAM_PRE].getValue(), 0.0f, 32.0f) / BUFFER_SIZE);
-			drawPre(args.vg, 1.0f * module->preCount / BUFFER_SIZE);
 		}
 		
 		NVGcolor getColor(int i) {
@@ -290,6 +538,40 @@ namespace {
 			col.a = 1.0f;
 			return col;
 		}
+
+		void onButton(const event::Button &e) override {
+			if (module && module->zoom > 1.0f && e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS)
+				e.consume(this);
+		}
+		void onDragMove(const event::DragMove &e) override {
+			if (module && module->zoom > 1.0f && e.button == GLFW_MOUSE_BUTTON_LEFT) {
+				e.consume(this);
+				float width = 1.0f / module->zoom;
+				module->pan = clamp(module->pan - e.mouseDelta.x / box.size.x * width / (1.0f - width), 0.0f, 1.0f);
+			}
+		}
+		// Ctrl + scroll zooms, so that scrolling over the display still scrolls the rack
+		void onHoverScroll(const event::HoverScroll &e) override {
+			if (!module || (APP->window->getMods() & RACK_MOD_MASK) != RACK_MOD_CTRL)
+				return;
+			e.consume(this);
+			// Zoom in until there are at least 32 samples across the display
+			const LA_Sweep &sweep = module->sweeps.read();
+			float maxZoom = std::max(1.0f, (sweep.end - sweep.start) / 32.0f);
+			float zoom = clamp(module->zoom * powf(2.0f, e.scrollDelta.y / 50.0f), 1.0f, maxZoom);
+			if (zoom <= 1.0f) {
+				module->zoom = 1.0f;
+				module->pan = 0.0f;
+				return;
+			}
+			// Keep the sample under the mouse where it is
+			float mouse = e.pos.x / box.size.x;
+			float width = 1.0f / module->zoom;
+			float newWidth = 1.0f / zoom;
+			float left = module->pan * (1.0f - width) + mouse * (width - newWidth);
+			module->pan = clamp(left / (1.0f - newWidth), 0.0f, 1.0f);
+			module->zoom = zoom;
+		}
 	};
 
 	struct LA_Measure : LightWidget {
@@ -303,7 +585,7 @@ namespace {
 			float deltaTime = powf(2.0f, module->params[LA_108::PARAM_TIME].getValue());
 			int frameCount = (int)ceilf(deltaTime * APP->engine->getSampleRate());
 			frameCount *= BUFFER_SIZE;
-			float width = (float)frameCount * fabs(module->params[LA_108::PARAM_INDEX_1].getValue() - module->params[LA_108::PARAM_INDEX_2].getValue()) / APP->engine->getSampleRate(); 
+			float width = (float)frameCount / module->zoom * fabs(module->params[LA_108::PARAM_INDEX_1].getValue() - module->params[LA_108::PARAM_INDEX_2].getValue()) / APP->engine->getSampleRate(); 
 			
 			if (width < 0.00000995f)
 				sprintf(measureText, "%4.3f\xc2\xb5s", width * 1000000.0f);
@@ -387,6 +669,17 @@ struct LA108 : SchemeModuleWidget {
 			};
 			menu->addChild(vmi);
 		}
+		LA_108 *laMod = dynamic_cast<LA_108 *>(module);
+		if (laMod) {
+			EventWidgetMenuItem *pmi = createMenuItem<EventWidgetMenuItem>("Polyphonic Capture");
+			pmi->stepHandler = [=]() {
+				pmi->rightText = CHECKMARK(laMod->poly);
+			};
+			pmi->clickHandler = [=]() {
+				laMod->poly = !laMod->poly;
+			};
+			menu->addChild(pmi);
+		}
 	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		drawBase(vg, "LA-108");
@@ -442,3 +735,4 @@ struct LA108 : SchemeModuleWidget {
 };
 
 Model *modelLA108 = createModel<LA_108, LA108>("LA-108");
+#endif
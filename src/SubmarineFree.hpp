@@ -35,6 +35,7 @@ extern Model *modelDO105;
 extern Model *modelDO110;
 extern Model *modelDO115;
 extern Model *modelDO120;
+extern Model *modelDO200;
 
 extern Model *modelEN104;
 extern Model *modelEO102;
@@ -103,6 +104,8 @@ extern Model *modelXG106;
 
 extern Model *modelXX219;
 
+#ifndef SUBMARINE_HEADLESS
 #include "shared/components.hpp"
+#endif
 
 #define SUBMENU "\xe2\x96\xb6"
@@ -16,11 +16,12 @@ namespace {
 } // end namespace
 
 struct TD_116 : Module {
-	TDInput inPort = TDInput(this, 0);
-	Torpedo::PatchOutputPort outPort = Torpedo::PatchOutputPort(this, 0);
+	TDInput inPort {this, 0};
+	Torpedo::PatchOutputPort outPort {this, 0};
 	TD_116() : Module () {
 		config(0, 1, 1, 0);
-		outPort.size(1);
+		inPort.defer(1 << 16);
+		outPort.size(1, 1 << 16);
 	}
 	void processExpander(float *message) {
 		if (!std::isnan(message[0])) {
@@ -56,15 +57,29 @@ struct TD_116 : Module {
 		inPort.process();
 		outPort.process();
 	}
+	// Called from the UI thread. Text is only posted to the engine once the previous text 
+	// has been taken, so only the latest text is ever waiting to be sent.
 	void sendText(std::string textValue) {
 		text = textValue;
-		
+		textToSend = true;
+		textTooLong = false;
+		postText();
+	}
+	void postText() {
+		if (!textToSend || textTooLong || !outPort.isPostable())
+			return;
+
 		json_t *rootJ = json_object();;
 
 		// text
 		json_object_set_new(rootJ, "text", json_string(text.c_str()));
 
-		outPort.send("SubmarineFree", "TDNotesText", rootJ); 
+		// The port was free, so a refusal means the text doesn't fit in its slot. It isn't 
+		// tried again until the text changes.
+		if (outPort.post("SubmarineFree", "TDNotesText", rootJ))
+			textToSend = false;
+		else
+			textTooLong = true;
 	}
 	void onReset() override {
 		reset = 1;
@@ -77,6 +92,7 @@ struct TD_116 : Module {
 		json_object_set_new(rootJ, "size", json_real(fontSize));
 		json_object_set_new(rootJ, "fg", json_string(color::toHexString(fg).c_str()));
 		json_object_set_new(rootJ, "bg", json_string(color::toHexString(bg).c_str()));
+		json_object_set_new(rootJ, "wide", json_boolean(outPort.wide));
 
 		return rootJ;
 	}
@@ -102,6 +118,10 @@ struct TD_116 : Module {
 			bg = color::fromHexString(json_string_value(bgJ));
 			isDirtyC = true;
 		}
+		json_t *wideJ = json_object_get(rootJ, "wide");
+		if (wideJ) {
+			outPort.wide = json_is_true(wideJ);
+		}
 	}
 
 	std::string text;
@@ -111,6 +131,8 @@ struct TD_116 : Module {
 	NVGcolor bg = nvgRGB(0,0,0);
 	int isDirty = false;
 	int isDirtyC = false;
+	bool textToSend = false;
+	bool textTooLong = false;
 };
 
 namespace {
@@ -126,6 +148,16 @@ namespace {
 				tdModule->sendText(text);
 			}
 		}
+		void draw(const DrawArgs &args) override {
+			SubText::draw(args);
+			if (tdModule && tdModule->textTooLong) {
+				nvgFontSize(args.vg, 10);
+				nvgFontFaceId(args.vg, gScheme.font()->handle);
+				nvgFillColor(args.vg, nvgRGB(0xff, 0x40, 0x40));
+				nvgTextAlign(args.vg, NVG_ALIGN_RIGHT | NVG_ALIGN_BOTTOM);
+				nvgText(args.vg, box.size.x - 4, box.size.y - 4, "Too long to send", NULL);
+			}
+		}
 		void foregroundMenu(Menu *menu) override {
 			SubText::foregroundMenu(menu);
 			menu->addChild(createForegroundMenuItem("Black", nvgRGB(0, 0, 0)));
@@ -227,6 +259,8 @@ struct TD116 : SchemeModuleWidget {
 		if (!tdModule) {
 			return;
 		}
+		tdModule->inPort.dispatch();
+		tdModule->postText();
 		if (tdModule->isDirty) {
 			textField->text = tdModule->text;
 			tdModule->isDirty = false;
@@ -254,6 +288,18 @@ struct TD116 : SchemeModuleWidget {
 	void appendContextMenu(Menu *menu) override {
 		SchemeModuleWidget::appendContextMenu(menu);
 		textField->appendContextMenu(menu);
+		TD_116 *tdModule = dynamic_cast<TD_116 *>(module);
+		if (tdModule) {
+			menu->addChild(new MenuSeparator);
+			EventWidgetMenuItem *wmi = createMenuItem<EventWidgetMenuItem>("Wide Torpedo Output");
+			wmi->stepHandler = [=]() {
+				wmi->rightText = CHECKMARK(tdModule->outPort.wide);
+			};
+			wmi->clickHandler = [=]() {
+				tdModule->outPort.wide = !tdModule->outPort.wide;
+			};
+			menu->addChild(wmi);
+		}
 	}
 
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
@@ -41,7 +41,7 @@ struct TF : Module  {
 
 	float prevValues[7] {NAN,NAN,NAN,NAN,NAN,NAN,NAN};
 	int isDirty = false;
-	Torpedo::PatchOutputPort outPort = Torpedo::PatchOutputPort(this, OUTPUT_TOR);	
+	Torpedo::PatchOutputPort outPort {this, OUTPUT_TOR};
 	float messages[2][7] = {{NAN,NAN,NAN,NAN,NAN,NAN,NAN},{NAN,NAN,NAN,NAN,NAN,NAN,NAN}};
 	TF() : Module() {
 		config(hasParams * NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
@@ -58,7 +58,7 @@ struct TF : Module  {
 		prevValues[1] = 0.6902f;
 		prevValues[2] = 0.9529f;
 		prevValues[6] = 12.0f;
-		outPort.size(1);
+		outPort.size(1, 1 << 10);
 		leftExpander.producerMessage = rightExpander.producerMessage = messages[0];
 		leftExpander.consumerMessage = rightExpander.consumerMessage = messages[1];	
 	}
@@ -76,17 +76,6 @@ struct TF : Module  {
 			isDirty = true;
 			prevValues[6] = newValue;
 		}
-		if (isDirty) {
-			isDirty = false;
-			json_t *rootJ = json_object();
-			if (hasParams || inputs[INPUT_FG_RED].isConnected() || inputs[INPUT_FG_GREEN].isConnected() || inputs[INPUT_FG_BLUE].isConnected())
-				json_object_set_new(rootJ, "fg", json_string(encodeColor(prevValues[0], prevValues[1], prevValues[2]).c_str()));
-			if (hasParams || inputs[INPUT_BG_RED].isConnected() || inputs[INPUT_BG_GREEN].isConnected() || inputs[INPUT_BG_BLUE].isConnected())
-				json_object_set_new(rootJ, "bg", json_string(encodeColor(prevValues[3], prevValues[4], prevValues[5]).c_str()));
-			if (hasParams || inputs[INPUT_FONT_SIZE].isConnected())
-				json_object_set_new(rootJ, "size", json_real(prevValues[6]));
-			outPort.send("SubmarineFree", "TDNotesColor", rootJ);
-		}
 		outPort.process();
 		float *message = (float *)(leftExpander.producerMessage);
 		if (hasParams || inputs[INPUT_FG_RED].isConnected() || inputs[INPUT_FG_GREEN].isConnected() || inputs[INPUT_FG_BLUE].isConnected()) {
@@ -114,6 +103,21 @@ struct TF : Module  {
 		leftExpander.messageFlipRequested = true;
 		rightExpander.messageFlipRequested = true;
 	}
+	// Called from the UI thread, so that the message is encoded there rather than on the 
+	// engine thread
+	void postColors() {
+		if (!isDirty || !outPort.isPostable())
+			return;
+		isDirty = false;
+		json_t *rootJ = json_object();
+		if (hasParams || inputs[INPUT_FG_RED].isConnected() || inputs[INPUT_FG_GREEN].isConnected() || inputs[INPUT_FG_BLUE].isConnected())
+			json_object_set_new(rootJ, "fg", json_string(encodeColor(prevValues[0], prevValues[1], prevValues[2]).c_str()));
+		if (hasParams || inputs[INPUT_BG_RED].isConnected() || inputs[INPUT_BG_GREEN].isConnected() || inputs[INPUT_BG_BLUE].isConnected())
+			json_object_set_new(rootJ, "bg", json_string(encodeColor(prevValues[3], prevValues[4], prevValues[5]).c_str()));
+		if (hasParams || inputs[INPUT_FONT_SIZE].isConnected())
+			json_object_set_new(rootJ, "size", json_real(prevValues[6]));
+		outPort.post("SubmarineFree", "TDNotesColor", rootJ);
+	}
 	std::string encodeColor(float r, float g, float b) {
 		std::string out;
 		out.push_back('A'+(int)(r * 255) / 16);	
@@ -164,6 +168,11 @@ struct TF101 : SchemeModuleWidget {
 
 		addOutput(createOutputCentered<BlackPort>(Vec(73.5,31.5), module, TF<true>::OUTPUT_TOR));
 	}
+	void step() override {
+		if (module)
+			static_cast<TF<true> *>(module)->postColors();
+		SchemeModuleWidget::step();
+	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		drawBase(vg, "TF-101");
 		nvgStrokeColor(vg, gScheme.getContrast(module));
@@ -210,6 +219,11 @@ struct TF102 : SchemeModuleWidget {
 
 		addOutput(createOutputCentered<BlackPort>(Vec(15,40), module, TF<true>::OUTPUT_TOR));
 	}
+	void step() override {
+		if (module)
+			static_cast<TF<false> *>(module)->postColors();
+		SchemeModuleWidget::step();
+	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		drawBase(vg, "TF-102");
 		nvgStrokeColor(vg, gScheme.getContrast(module));
@@ -3,6 +3,10 @@
 #include "SubmarineFree.hpp"
 #include "shared/torpedo.hpp"
 
+// The longest message forwarded, the same as the TD-116 buffer. Storage for it is reserved 
+// up front, so that forwarding never allocates on the engine thread.
+#define TM_MAX_MESSAGE (1 << 16)
+
 struct TM_105;
 
 namespace {
@@ -10,13 +14,16 @@ namespace {
 	struct TM_105InPort : Torpedo::RawInputPort {
 		TM_105 *tmModule;
 		TM_105InPort(TM_105 *module, unsigned int portNum) : RawInputPort((Module *)module, portNum) {tmModule = module;}
-		void received(std::string appId, std::string message) override;
+		void received(const std::string &appId, const std::string &message) override;
 		void error(unsigned int errorType) override;
 	};
 
 	struct TM_Msg {
 		std::string appId;
 		std::string msg;
+		unsigned int input;
+		unsigned int sequence;
+		bool used = false;
 	};
 } // end namespace
 
@@ -55,64 +62,198 @@ struct TM_105 : Module  {
 		NUM_LIGHTS
 	};
 
+	// The 5 slots are shared between the inputs, but are sent round-robin by input, so 
+	// that one busy input can't hold up the others. When the buffer is full, the input 
+	// with the most messages waiting gives up its newest one.
 	std::vector<TM_Msg> queue;
 	unsigned int count = 0;
-	unsigned int index = 0;
-	TM_105InPort inPort1 = TM_105InPort(this, INPUT_1);
-	TM_105InPort inPort2 = TM_105InPort(this, INPUT_2);
-	TM_105InPort inPort3 = TM_105InPort(this, INPUT_3);
-	TM_105InPort inPort4 = TM_105InPort(this, INPUT_4);
-	TM_105InPort inPort5 = TM_105InPort(this, INPUT_5);
+	unsigned int sequence = 0;
+	unsigned int lastInput = 4;
+	unsigned int sent[5] = {};
+	unsigned int dropped[5] = {};
+	TM_105InPort inPort1 {this, INPUT_1};
+	TM_105InPort inPort2 {this, INPUT_2};
+	TM_105InPort inPort3 {this, INPUT_3};
+	TM_105InPort inPort4 {this, INPUT_4};
+	TM_105InPort inPort5 {this, INPUT_5};
 	dsp::PulseGenerator msgPulses[5];
 	dsp::PulseGenerator errPulses[5];
-	Torpedo::RawOutputPort outPort = Torpedo::RawOutputPort(this, OUTPUT_TOR);	
+	// In multiplexed mode each output port drives its own lane of the output, so up to 5 
+	// messages are sent at once. Otherwise only the first is used, across every channel.
+	Torpedo::RawOutputPort outPorts[5] = {
+		{this, OUTPUT_TOR},
+		{this, OUTPUT_TOR},
+		{this, OUTPUT_TOR},
+		{this, OUTPUT_TOR},
+		{this, OUTPUT_TOR}
+	};
+	bool wide = false;
+	bool multiplex = false;
+	// The mode only changes once every lane is idle, so no message is cut short
+	bool multiplexing = false;
 	TM_105() : Module() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 		for (unsigned int i = 0; i < 5; i++) {
 			queue.push_back(TM_Msg());
+			queue.back().msg.reserve(TM_MAX_MESSAGE);
+			outPorts[i]._message.reserve(TM_MAX_MESSAGE);
 		}
+		inPort1.limit(TM_MAX_MESSAGE);
+		inPort2.limit(TM_MAX_MESSAGE);
+		inPort3.limit(TM_MAX_MESSAGE);
+		inPort4.limit(TM_MAX_MESSAGE);
+		inPort5.limit(TM_MAX_MESSAGE);
 	}
 	void process(const ProcessArgs &args) override;
+	void drop(unsigned int input);
+	void sendNext(unsigned int lane);
+	unsigned int waiting(unsigned int input);
+	void onReset() override {
+		for (TM_Msg &msg : queue)
+			msg.used = false;
+		count = 0;
+		for (unsigned int i = 0; i < 5; i++) {
+			sent[i] = 0;
+			dropped[i] = 0;
+		}
+	}
+	json_t *dataToJson() override {
+		json_t *rootJ = json_object();
+		json_object_set_new(rootJ, "wide", json_boolean(wide));
+		json_object_set_new(rootJ, "multiplex", json_boolean(multiplex));
+		return rootJ;
+	}
+	void dataFromJson(json_t *rootJ) override {
+		json_t *wideJ = json_object_get(rootJ, "wide");
+		if (wideJ) {
+			wide = json_is_true(wideJ);
+		}
+		json_t *multiplexJ = json_object_get(rootJ, "multiplex");
+		if (multiplexJ) {
+			multiplex = json_is_true(multiplexJ);
+		}
+	}
 };
 
 namespace {
-	void TM_105InPort::received(std::string appId, std::string msg) {
-		if (tmModule->count >= 5) {
+	void TM_105InPort::received(const std::string &appId, const std::string &msg) {
+		unsigned int input = _portNum - TM_105::INPUT_1;
+		// Longer messages would have to grow a slot
+		if (msg.length() > TM_MAX_MESSAGE) {
+			tmModule->drop(input);
 			return;
 		}
-		unsigned int newPos = (tmModule->index + tmModule->count) % 5; 
-		tmModule->queue[newPos].appId.assign(appId);
-		tmModule->queue[newPos].msg.assign(msg);
+		if (tmModule->count >= 5) {
+			unsigned int busiest = input;
+			for (unsigned int i = 0; i < 5; i++) {
+				if (tmModule->waiting(i) > tmModule->waiting(busiest))
+					busiest = i;
+			}
+			if (tmModule->waiting(busiest) <= tmModule->waiting(input) + 1) {
+				tmModule->drop(input);
+				return;
+			}
+			// Make room by dropping the busiest input's newest message
+			unsigned int victim = 5;
+			for (unsigned int i = 0; i < 5; i++) {
+				if (tmModule->queue[i].used && tmModule->queue[i].input == busiest) {
+					if (victim == 5 || tmModule->queue[i].sequence - tmModule->queue[victim].sequence < 0x80000000)
+						victim = i;
+				}
+			}
+			tmModule->queue[victim].used = false;
+			tmModule->count--;
+			tmModule->drop(busiest);
+		}
+		for (TM_Msg &slot : tmModule->queue) {
+			if (slot.used)
+				continue;
+			slot.appId.assign(appId);
+			slot.msg.assign(msg);
+			slot.input = input;
+			slot.sequence = tmModule->sequence++;
+			slot.used = true;
+			break;
+		}
 		tmModule->count++;
-		tmModule->msgPulses[_portNum - TM_105::INPUT_1].trigger(0.1f);
+		tmModule->msgPulses[input].trigger(0.1f);
 	}
 
 	void TM_105InPort::error(unsigned int errorType) {
+		if (errorType == ERROR_OVERSIZE) {
+			tmModule->drop(_portNum - TM_105::INPUT_1);
+			return;
+		}
 		tmModule->errPulses[_portNum - TM_105::INPUT_1].trigger(0.1f);
 	}
 } // end namespace
 
+void TM_105::drop(unsigned int input) {
+	dropped[input]++;
+	errPulses[input].trigger(0.1f);
+}
+
+unsigned int TM_105::waiting(unsigned int input) {
+	unsigned int n = 0;
+	for (TM_Msg &slot : queue) {
+		if (slot.used && slot.input == input)
+			n++;
+	}
+	return n;
+}
+
+// Send the oldest message from the next input after the last one sent
+void TM_105::sendNext(unsigned int lane) {
+	unsigned int sendPos = 5;
+	for (unsigned int i = 1; i <= 5 && sendPos == 5; i++) {
+		unsigned int input = (lastInput + i) % 5;
+		for (unsigned int j = 0; j < 5; j++) {
+			if (!queue[j].used || queue[j].input != input)
+				continue;
+			if (sendPos == 5 || queue[sendPos].sequence - queue[j].sequence < 0x80000000)
+				sendPos = j;
+		}
+	}
+	outPorts[lane].send(queue[sendPos].appId, queue[sendPos].msg);
+	queue[sendPos].used = false;
+	lastInput = queue[sendPos].input;
+	sent[lastInput]++;
+	count--;
+}
+
 void TM_105::process(const ProcessArgs &args) {
 	inPort1.process();
 	inPort2.process();
 	inPort3.process();
 	inPort4.process();
 	inPort5.process();
-	if (!outPort.isBusy()) {
-		if (count) {
-			unsigned int sendPos = (count + index) % 5;
-			outPort.send(queue[sendPos].appId, queue[sendPos].msg);
-			index++;
-			index %= 5;
-			count--;
-		}
+	if (multiplexing != multiplex) {
+		bool idle = true;
+		for (Torpedo::RawOutputPort &outPort : outPorts)
+			idle = idle && !outPort.isBusy();
+		if (idle)
+			multiplexing = multiplex;
+	}
+	unsigned int lanes = multiplexing ? 5 : 1;
+	for (unsigned int lane = 0; lane < lanes; lane++) {
+		outPorts[lane].wide = wide;
+		if (count && !outPorts[lane].isBusy())
+			sendNext(lane);
 	}
 	for(unsigned int i = 0; i < 5; i++) {
 		lights[LIGHT_Q_1 + i].setBrightness(count > i);
 		lights[LIGHT_M_1 + i].setBrightness(msgPulses[i].process(args.sampleTime)); 
 		lights[LIGHT_E_1 + i].setBrightness(errPulses[i].process(args.sampleTime)); 
 	}
-	outPort.process();
+	if (multiplexing) {
+		outputs[OUTPUT_TOR].setChannels(16);
+		outputs[OUTPUT_TOR].setVoltage(1.0f * (Torpedo::BasePort::LANE_MARKER | 5), 0);
+		for (unsigned int lane = 0; lane < 5; lane++)
+			outPorts[lane].processLane(1 + 3 * lane, 3);
+	}
+	else {
+		outPorts[0].process();
+	}
 }
 
 struct TM105 : SchemeModuleWidget {
@@ -132,6 +273,35 @@ struct TM105 : SchemeModuleWidget {
 		addChild(createLightCentered<TinyLight<RedLight>>(Vec(15, 281.5), module, TM_105::LIGHT_Q_5));
 		addOutput(createOutputCentered<BlackPort>(Vec(15,244.5), module, TM_105::OUTPUT_TOR));
 	}
+	void appendContextMenu(Menu *menu) override {
+		SchemeModuleWidget::appendContextMenu(menu);
+		TM_105 *tmModule = dynamic_cast<TM_105 *>(module);
+		if (tmModule) {
+			menu->addChild(new MenuSeparator);
+			EventWidgetMenuItem *wmi = createMenuItem<EventWidgetMenuItem>("Wide Torpedo Output");
+			wmi->stepHandler = [=]() {
+				wmi->rightText = CHECKMARK(tmModule->wide);
+			};
+			wmi->clickHandler = [=]() {
+				tmModule->wide = !tmModule->wide;
+			};
+			menu->addChild(wmi);
+			EventWidgetMenuItem *mmi = createMenuItem<EventWidgetMenuItem>("Multiplexed Output");
+			mmi->stepHandler = [=]() {
+				mmi->rightText = CHECKMARK(tmModule->multiplex);
+			};
+			mmi->clickHandler = [=]() {
+				tmModule->multiplex = !tmModule->multiplex;
+			};
+			menu->addChild(mmi);
+			menu->addChild(new MenuSeparator);
+			for (unsigned int i = 0; i < 5; i++) {
+				MenuLabel *menuLabel = new MenuLabel();
+				menuLabel->text = string::f("Input %d: %u sent, %u dropped", i + 1, tmModule->sent[i], tmModule->dropped[i]);
+				menu->addChild(menuLabel);
+			}
+		}
+	}
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		drawBase(vg, "TM-105");
 		drawText(vg, 15, 27, NVG_ALIGN_CENTER | NVG_ALIGN_BASELINE, 8, gScheme.getContrast(module), "IN");
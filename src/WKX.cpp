@@ -241,15 +241,16 @@ struct WK_101 : Module {
 	};
 	int toSend = 0;
 	unsigned int light = PARAM_1;
-	Torpedo::PatchOutputPort outPort = Torpedo::PatchOutputPort(this, OUTPUT_TOR);
-	WK101_InputPort inPort = WK101_InputPort(this, INPUT_TOR);
+	Torpedo::PatchOutputPort outPort {this, OUTPUT_TOR};
+	WK101_InputPort inPort {this, INPUT_TOR};
 
 	WK_101() : Module() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 		for (unsigned int i = 0; i < NUM_PARAMS; i++) {
 			configParam(PARAM_1 + i, -50.0f, 50.0f, 0.0f, "Detune", " cents");
 		}
-		outPort.size(5);
+		outPort.size(5, 1 << 12);
+		inPort.defer(1 << 12);
 	}
 
 	void process(const ProcessArgs &args) override {
@@ -257,15 +258,32 @@ struct WK_101 : Module {
 		int note = (120 + quantized) % 12;
 		outputs[OUTPUT_CV].setVoltage((params[PARAM_1 + note].getValue() / 1200.0f) + (quantized / 12.0f));	
 		light = note;
-		if (toSend && !outPort.isBusy()) {
+		outPort.process();
+		inPort.process();
+	}
+	// Called from the UI thread, which encodes and decodes the tunings so that the engine 
+	// thread only has to move bytes. The tunings are posted once the previous ones have
+	// been taken, so the latest tunings are always the next to be sent.
+	void updatePorts() {
+		inPort.dispatch();
+		if (toSend && outPort.isPostable()) {
 			toSend = 0;
 			json_t *rootJ = json_array();
 			for (int i = 0; i < 12; i++)
 				json_array_append_new(rootJ, json_real(params[PARAM_1 + i].getValue()));
-			outPort.send(std::string(TOSTRING(SLUG)), std::string("WK"), rootJ);
+			outPort.post(std::string(TOSTRING(SLUG)), std::string("WK"), rootJ);
+		}
+	}
+	json_t *dataToJson(void) override {
+		json_t *rootJ = json_object();
+		json_object_set_new(rootJ, "wide", json_boolean(outPort.wide));
+		return rootJ;
+	}
+	void dataFromJson(json_t *rootJ) override {
+		json_t *wideJ = json_object_get(rootJ, "wide");
+		if (wideJ) {
+			outPort.wide = json_is_true(wideJ);
 		}
-		outPort.process();
-		inPort.process();
 	}
 };
 
@@ -367,6 +385,11 @@ struct WK101 : SchemeModuleWidget {
 		WK_Tunings::loadTunings(pluginInstance);
 	}
 	void appendContextMenu(Menu *menu) override;
+	void step() override {
+		if (module)
+			static_cast<WK_101 *>(module)->updatePorts();
+		SchemeModuleWidget::step();
+	}
 
 	void render(NVGcontext *vg, SchemeCanvasWidget *canvas) override {
 		drawBase(vg, "WK-101");
@@ -546,6 +569,15 @@ void WK101::appendContextMenu(Menu *menu) {
 			};
 			menu->addChild(m);
 		}
+		menu->addChild(new MenuEntry);
+		EventWidgetMenuItem *wmi = createMenuItem<EventWidgetMenuItem>("Wide Torpedo Output");
+		wmi->stepHandler = [=]() {
+			wmi->rightText = CHECKMARK(module->outPort.wide);
+		};
+		wmi->clickHandler = [=]() {
+			module->outPort.wide = !module->outPort.wide;
+		};
+		menu->addChild(wmi);
 	}
 }
 
@@ -587,10 +619,11 @@ struct WK_205 : Module {
 		NUM_LIGHTS
 	};
 	float tunings[12];
-	WK205_InputPort inPort = WK205_InputPort(this, INPUT_TOR);
+	WK205_InputPort inPort {this, INPUT_TOR};
 
 	WK_205() : Module() {
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		inPort.defer(1 << 12);
 	}
 	void process(const ProcessArgs &args) override;
 	json_t *dataToJson(void) override {
@@ -651,6 +684,11 @@ struct WK205 : SchemeModuleWidget {
 
 		WK_Tunings::loadTunings(pluginInstance);
 	}
+	void step() override {
+		if (module)
+			static_cast<WK_205 *>(module)->inPort.dispatch();
+		SchemeModuleWidget::step();
+	}
 	void appendContextMenu(Menu *menu) override {
 		SchemeModuleWidget::appendContextMenu(menu);
 		WK_205 *module = dynamic_cast<WK_205 *>(this->module);
@@ -2,6 +2,7 @@
 #include <settings.hpp>
 #include <system.hpp>
 #include <osdialog.h>
+#include <unordered_map>
 #include "SubmarineFree.hpp"
 
 struct BackPanel : Widget {
@@ -627,8 +628,22 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 	ModuleWidget *lastHover = NULL;
 	bool highlightIsDirty = true;
 
-	int cableCount = 0;
+	// Cables are tracked by id. The cable container is only walked when its size, its 
+	// last cable or the cable being dragged has changed.
+	std::unordered_map<int, CableWidget *> knownCables;
+	size_t cableCount = 0;
 	Widget *lastCable = NULL;
+	CableWidget *lastIncompleteCable = NULL;
+	CableWidget *draggedCable = NULL;
+	// The cables attached to each module, so that a change of hover only has to touch 
+	// the cables of the modules gaining and losing focus.
+	std::unordered_map<ModuleWidget *, std::vector<CableWidget *>> cableIndex;
+	// Cables waiting to be colored, newest last. A few are colored each frame so that 
+	// loading a large patch doesn't stall the UI, and the colors from one batch are 
+	// undone together.
+	std::vector<int> recolorQueue;
+	history::ComplexAction *recolorAction = NULL;
+	bool recolorAll = false;
 	unsigned int newColorIndex = 0;
 
 	MinButton *minButton;
@@ -1010,6 +1025,8 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 	}
 	~WM101() {
 		this->_delete();
+		if (recolorAction)
+			delete recolorAction;
 	}
 	void onHoverKey(const event::HoverKey &e) override {
 		ModuleWidget::onHoverKey(e);
@@ -1123,6 +1140,7 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 		scrollWidget->container->clearChildren();
 		collectionScrollWidget->container->clearChildren();
 		loadSettings();
+		rebuildCableIndex();
 	}
 	void step() override {
 		if (!module) {
@@ -1130,7 +1148,7 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 		}
 		if (!stabilized) {
 			stabilized = true;
-			cableCount = APP->scene->rack->cableContainer->children.size();
+			registerCables();
 		}
 		if (masterWireManager != this) {
 			if (masterWireManager) {
@@ -1142,34 +1160,8 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 			}
 			takeMasterSlot();
 		}
-		int newSize = APP->scene->rack->cableContainer->children.size();
-		if (newSize < cableCount) {
-			cableCount = newSize;
-			if (cableCount) 
-				lastCable = APP->scene->rack->cableContainer->children.back();
-			else
-				lastCable = NULL;
-		}
-		else if (newSize > cableCount) {
-			history::ComplexAction* complex = NULL;
-			if (cableCount == -1) {
-				complex = new history::ComplexAction();
-				complex->name = "Recolor All Wires";
-				APP->history->push(complex);
-				cableCount = 0;
-			}
-			std::list<Widget *>::reverse_iterator iterator = APP->scene->rack->cableContainer->children.rbegin();
-			for (int i = 0; i < newSize - cableCount; i++) {
-				colorCable(*iterator, complex);
-				++iterator;
-			}
-			cableCount = newSize;
-			if (cableCount)
-				lastCable = APP->scene->rack->cableContainer->children.back();
-			else
-				lastCable = NULL;
-			highlightIsDirty = true;		
-		}
+		trackCables();
+		processRecolorQueue();
 		if (wirePanel->visible && APP->scene->rack->incompleteCable) {
 			colorCable(APP->scene->rack->incompleteCable,NULL);
 		}
@@ -1186,36 +1178,159 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 			}
 		}
 		if (focusedModuleWidget != lastHover) {
+			// Cables away from the focused module are dimmed whenever there is a focused 
+			// module, or always when highlighting is fully on. If that hasn't changed, only 
+			// the cables of the old and new focused modules need to be touched.
+			bool wasDimmed = lastHover || (highlight == HIGHLIGHT_ON);
+			bool isDimmed = focusedModuleWidget || (highlight == HIGHLIGHT_ON);
+			ModuleWidget *previous = lastHover;
 			lastHover = focusedModuleWidget;
-			highlightIsDirty = true;
+			if (wasDimmed != isDimmed || highlightIsDirty) {
+				highlightIsDirty = true;
+			}
+			else {
+				if (previous)
+					highlightModuleCables(previous, isDimmed);
+				if (lastHover)
+					highlightModuleCables(lastHover, false);
+				if (APP->scene->rack->incompleteCable)
+					highlightCable(APP->scene->rack->incompleteCable, !lastHover && isDimmed);
+			}
 		}
 		if (highlightIsDirty) {
 			highlightIsDirty = false;
+			bool isDimmed = lastHover || (highlight == HIGHLIGHT_ON);
 			for (Widget *widget : APP->scene->rack->cableContainer->children) {
 				CableWidget *cable = dynamic_cast<CableWidget *>(widget);
-				if (focusedModuleWidget) {
-					if (!cable->outputPort || !cable->inputPort) {
-						cable->color = nvgTransRGBA(cable->color, 0xFF);
-					}
-					else if (cable->outputPort->getAncestorOfType<ModuleWidget>() == focusedModuleWidget) {
-						cable->color = nvgTransRGBA(cable->color, 0xFF);
-					}
-					else if (cable->inputPort->getAncestorOfType<ModuleWidget>() == focusedModuleWidget) {
-						cable->color = nvgTransRGBA(cable->color, 0xFF);
-					}
-					else {
-						cable->color = nvgTransRGBAf(cable->color, highlightSlider->value);
-					}
-				}
-				else {
-					if (highlight == 2)
-						cable->color = nvgTransRGBAf(cable->color, highlightSlider->value);
-					else
-						cable->color = nvgTransRGBA(cable->color, 0xFF);
-				}
-
+				if (lastHover && (!cable->outputPort || !cable->inputPort))
+					highlightCable(cable, false);
+				else
+					highlightCable(cable, isDimmed);
 			}
+			if (lastHover)
+				highlightModuleCables(lastHover, false);
+		}
+	}
+	void registerCables() {
+		knownCables.clear();
+		for (Widget *widget : APP->scene->rack->cableContainer->children) {
+			CableWidget *cable = dynamic_cast<CableWidget *>(widget);
+			if (cable != APP->scene->rack->incompleteCable && cable->cable->id > -1)
+				knownCables[cable->cable->id] = cable;
+		}
+		cableCount = APP->scene->rack->cableContainer->children.size();
+		lastCable = cableCount ? APP->scene->rack->cableContainer->children.back() : NULL;
+		lastIncompleteCable = APP->scene->rack->incompleteCable;
+		rebuildCableIndex();
+	}
+	void trackCables() {
+		std::list<Widget *> &children = APP->scene->rack->cableContainer->children;
+		CableWidget *incompleteCable = APP->scene->rack->incompleteCable;
+		Widget *backCable = children.size() ? children.back() : NULL;
+		if (children.size() == cableCount && backCable == lastCable && incompleteCable == lastIncompleteCable)
+			return;
+		cableCount = children.size();
+		lastCable = backCable;
+		if (incompleteCable != lastIncompleteCable) {
+			lastIncompleteCable = incompleteCable;
+			// A new cable being dragged is colored straight away, but not one that has 
+			// been picked up from a port. Neither is colored again when it is plugged in.
+			if (incompleteCable) {
+				auto it = knownCables.find(incompleteCable->cable->id);
+				if (it == knownCables.end() || it->second != incompleteCable)
+					colorCable(incompleteCable, NULL);
+				draggedCable = incompleteCable;
+			}
+		}
+		std::unordered_map<int, CableWidget *> currentCables;
+		currentCables.reserve(children.size());
+		std::vector<int> newCables;
+		size_t added = 0;
+		for (Widget *widget : children) {
+			CableWidget *cable = dynamic_cast<CableWidget *>(widget);
+			int id = cable->cable->id;
+			if (cable == incompleteCable || id < 0)
+				continue;
+			currentCables[id] = cable;
+			auto it = knownCables.find(id);
+			if (it != knownCables.end() && it->second == cable)
+				continue;
+			indexCable(cable);
+			added++;
+			if (cable == draggedCable)
+				draggedCable = NULL;
+			else
+				newCables.push_back(id);
 		}
+		bool removed = (knownCables.size() + added > currentCables.size());
+		knownCables.swap(currentCables);
+		if (removed)
+			rebuildCableIndex();
+		if (newCables.size() > 1 && !recolorAction) {
+			recolorAction = new history::ComplexAction();
+			recolorAction->name = "Color Wires";
+		}
+		recolorQueue.insert(recolorQueue.end(), newCables.begin(), newCables.end());
+		highlightIsDirty = true;
+	}
+	void recolorAllWires() {
+		recolorQueue.clear();
+		for (Widget *widget : APP->scene->rack->cableContainer->children) {
+			CableWidget *cable = dynamic_cast<CableWidget *>(widget);
+			if (knownCables.count(cable->cable->id))
+				recolorQueue.push_back(cable->cable->id);
+		}
+		if (!recolorAction)
+			recolorAction = new history::ComplexAction();
+		recolorAction->name = "Recolor All Wires";
+		recolorAll = true;
+	}
+	void processRecolorQueue() {
+		for (unsigned int i = 0; i < 250 && recolorQueue.size(); i++) {
+			auto it = knownCables.find(recolorQueue.back());
+			recolorQueue.pop_back();
+			if (it == knownCables.end())
+				continue;
+			if (!recolorAll && redoCheck->selected && !wirePanel->visible)
+				continue;
+			colorCable(it->second, recolorAction);
+			highlightIsDirty = true;
+		}
+		if (recolorQueue.size() || !recolorAction)
+			return;
+		if (recolorAction->isEmpty())
+			delete recolorAction;
+		else
+			APP->history->push(recolorAction);
+		recolorAction = NULL;
+		recolorAll = false;
+	}
+	void highlightCable(CableWidget *cable, bool dimmed) {
+		if (dimmed)
+			cable->color = nvgTransRGBAf(cable->color, highlightSlider->value);
+		else
+			cable->color = nvgTransRGBA(cable->color, 0xFF);
+	}
+	void highlightModuleCables(ModuleWidget *moduleWidget, bool dimmed) {
+		auto it = cableIndex.find(moduleWidget);
+		if (it == cableIndex.end())
+			return;
+		for (CableWidget *cable : it->second)
+			highlightCable(cable, dimmed);
+	}
+	void indexCable(CableWidget *cable) {
+		if (!cable->outputPort || !cable->inputPort)
+			return;
+		ModuleWidget *outputModule = cable->outputPort->getAncestorOfType<ModuleWidget>();
+		ModuleWidget *inputModule = cable->inputPort->getAncestorOfType<ModuleWidget>();
+		cableIndex[outputModule].push_back(cable);
+		if (inputModule != outputModule)
+			cableIndex[inputModule].push_back(cable);
+	}
+	void rebuildCableIndex() {
+		cableIndex.clear();
+		for (Widget *widget : APP->scene->rack->cableContainer->children)
+			indexCable(dynamic_cast<CableWidget *>(widget));
 	}
 	void colorCable(Widget *widget, history::ComplexAction *complex) {
 		CableWidget *cable = dynamic_cast<CableWidget *>(widget);
@@ -1514,16 +1629,14 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 	}
 	void loadSettings() {
 		json_error_t error;
-		FILE *file = fopen(asset::user("SubmarineFree/WM-101.json").c_str(), "r");
-		if (!file) {
-			file = fopen(asset::user("SubmarineUtility/WireManager.json").c_str(), "r");
+		json_t *rootJ = UserSettings::load("SubmarineFree/WM-101.json", &error);
+		if (!rootJ && !error.text[0]) {
+			rootJ = UserSettings::load("SubmarineUtility/WireManager.json", &error);
 		}
-		if (!file) {
+		if (!rootJ && !error.text[0]) {
 			setDefaults();
 			return;
 		}
-		json_t *rootJ = json_loadf(file, 0, &error);
-		fclose(file);
 		if (!rootJ) {
 			WARN("Submarine Free WM-101: JSON parsing error at %s %d:%d %s", error.source, error.line, error.column, error.text);
 			return;
@@ -1626,14 +1739,7 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 			json_array_append_new(arr, c1);
 		} 
 		json_object_set_new(settings, "collections", arr);
-		system::createDirectory(asset::user("SubmarineFree"));
-		std::string settingsFilename = asset::user("SubmarineFree/WM-101.json");
-		FILE *file = fopen(settingsFilename.c_str(), "w");
-		if (file) {
-			json_dumpf(settings, file, JSON_INDENT(2) | JSON_REAL_PRECISION(9));
-			fclose(file);
-		}
-		json_decref(settings);
+		UserSettings::save("SubmarineFree/WM-101.json", settings);
 	}
 	WireButton *findWireButton(unsigned int index) {
 		if (index >= scrollWidget->container->children.size())
@@ -2237,7 +2343,7 @@ struct WM101 : SizeableModuleWidget, WM_Base {
 	void recolorAllDialog() {
 		deleteLabel->label = "Recolor All Wires?";
 		deleteOkButton->clickHandler = [=]() {
-			this->cableCount = -1;
+			this->recolorAllWires();
 			this->cancel();
 		};
 		backPanel->visible = false;
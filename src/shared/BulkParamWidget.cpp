@@ -19,6 +19,8 @@ void BulkParamTooltip::step() {
 }
 
 std::string BulkParamWidget::getString() {
+	if (getText)
+		return getText();
 	std::string s;
 	if (!label.empty())
 		s += label + ": ";
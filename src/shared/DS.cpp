@@ -29,6 +29,7 @@ float DS_Module::output(int state) {
 	return state?voltage1:voltage0;
 } 
 
+#ifndef SUBMARINE_HEADLESS
 struct DS_ParentMenuItem : MenuItem {
 	DS_Module *module;
 	Menu *createChildMenu() override {
@@ -78,6 +79,7 @@ void DS_MenuItem::step() {
 	rightText = CHECKMARK((module->voltage0 == vl) && (module->voltage1 == vh));
 	MenuItem::step();
 }
+#endif
 
 float DS_Schmitt::high(float v0, float v1) {
 	return (v0 * 0.4f + v1 * 0.6f);
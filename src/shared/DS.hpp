@@ -9,9 +9,12 @@ struct DS_Module : Module {
 	json_t *dataToJson() override;
 	void dataFromJson(json_t *) override;
 	void onReset() override;
+#ifndef SUBMARINE_HEADLESS
 	void appendContextMenu(Menu *);
+#endif
 };
 
+#ifndef SUBMARINE_HEADLESS
 struct DS_MenuItem : MenuItem {
 	DS_Module *module;
 	float vh;
@@ -19,6 +22,7 @@ struct DS_MenuItem : MenuItem {
 	void onAction(const event::Action &e) override;
 	void step() override;
 };
+#endif
 
 struct DS_Schmitt {
 	int _state = 0;
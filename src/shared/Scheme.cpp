@@ -9,12 +9,10 @@
 
 Scheme::Scheme() {
 	json_error_t error;
-	FILE *file = fopen(asset::user("SubmarineFree/Settings.json").c_str(), "r");
-	if (!file) {
+	json_t *rootJ = UserSettings::load("SubmarineFree/Settings.json", &error);
+	if (!rootJ && !error.text[0]) {
 		return;
 	}
-	json_t *rootJ = json_loadf(file, 0, &error);
-	fclose(file);
 	if (!rootJ) {
 		std::string message = string::f("Submarine Free Settings: JSON parsing error at %s %d:%d %s", error.source, error.line, error.column, error.text);
 		WARN(message.c_str());
@@ -43,14 +41,7 @@ void Scheme::save() {
 	json_object_set_new(settings, "flat", json_real(isFlat?1:0));
 	json_object_set_new(settings, "scheme", json_real(scheme));
 
-	system::createDirectory(asset::user("SubmarineFree"));
-	std::string settingsFilename = asset::user("SubmarineFree/Settings.json");
-	FILE *file = fopen(settingsFilename.c_str(), "w");
-	if (file) {
-		json_dumpf(settings, file, JSON_INDENT(2) | JSON_REAL_PRECISION(9));
-		fclose(file);
-	}
-	json_decref(settings);
+	UserSettings::save("SubmarineFree/Settings.json", settings);
 }
 
 void Scheme::setColors() {
@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+
+//
+// Lock-free handoff of whole frames from the engine thread to the UI thread.
+//
+// The engine fills write() and calls publish(); the UI calls update() and then draws
+// from read(). Neither side ever waits for the other. The UI always gets the most
+// recently published frame, and a frame is never written while the UI holds it.
+//
+
+template <typename T>
+struct TripleBuffer {
+	// Bit 2 of _middle is set when the frame in the middle slot hasn't been read yet
+	enum {
+		FRESH = 0x04,
+		INDEX = 0x03
+	};
+
+	T _frames[3] = {};
+	unsigned int _back = 0;
+	unsigned int _front = 1;
+	std::atomic<unsigned int> _middle { 2 };
+
+	// Engine thread
+	T &write() { return _frames[_back]; }
+	void publish() { _back = _middle.exchange(_back | FRESH) & INDEX; }
+
+	// UI thread
+	bool update() {
+		if (!(_middle.load() & FRESH))
+			return false;
+		_front = _middle.exchange(_front) & INDEX;
+		return true;
+	}
+	const T &read() { return _frames[_front]; }
+};
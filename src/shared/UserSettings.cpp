@@ -0,0 +1,117 @@
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "../SubmarineFree.hpp"
+
+namespace {
+
+	struct SettingsFile {
+		json_t *rootJ = NULL;
+		json_error_t error;
+		bool dirty = false;
+	};
+
+	// The files, and the thread that writes them. This is never destroyed, so that it 
+	// is still there when the guard below stops the writer.
+	struct SettingsState {
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::map<std::string, SettingsFile> files;
+		std::thread thread;
+		bool pending = false;
+		bool stopping = false;
+
+		void writeFiles() {
+			std::map<std::string, json_t *> toWrite;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto &f : files) {
+					if (f.second.dirty) {
+						f.second.dirty = false;
+						toWrite[f.first] = json_deep_copy(f.second.rootJ);
+					}
+				}
+				pending = false;
+			}
+			for (auto &f : toWrite) {
+				system::createDirectory(string::directory(asset::user(f.first)));
+				FILE *file = fopen(asset::user(f.first).c_str(), "w");
+				if (file) {
+					json_dumpf(f.second, file, JSON_INDENT(2) | JSON_REAL_PRECISION(9));
+					fclose(file);
+				}
+				json_decref(f.second);
+			}
+		}
+
+		void run() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				wake.wait(lock, [this]() { return pending || stopping; });
+				// Let further changes collect before writing
+				if (wake.wait_for(lock, std::chrono::milliseconds(500), [this]() { return stopping; }))
+					return;
+				lock.unlock();
+				writeFiles();
+				lock.lock();
+			}
+		}
+	};
+
+	SettingsState *state() {
+		static SettingsState *s = new SettingsState();
+		return s;
+	}
+
+	// Stop the writer before the plugin is unloaded, then write anything it hadn't got to
+	struct SettingsGuard {
+		~SettingsGuard() {
+			SettingsState *s = state();
+			{
+				std::lock_guard<std::mutex> lock(s->mutex);
+				s->stopping = true;
+			}
+			s->wake.notify_one();
+			if (s->thread.joinable())
+				s->thread.join();
+			s->writeFiles();
+		}
+	} settingsGuard;
+
+} // end namespace
+
+json_t *UserSettings::load(std::string path, json_error_t *error) {
+	SettingsState *s = state();
+	std::lock_guard<std::mutex> lock(s->mutex);
+	auto it = s->files.find(path);
+	if (it == s->files.end()) {
+		SettingsFile &f = s->files[path];
+		f.error.text[0] = 0;
+		FILE *file = fopen(asset::user(path).c_str(), "r");
+		if (file) {
+			f.rootJ = json_loadf(file, 0, &f.error);
+			fclose(file);
+		}
+		it = s->files.find(path);
+	}
+	*error = it->second.error;
+	if (!it->second.rootJ)
+		return NULL;
+	return json_deep_copy(it->second.rootJ);
+}
+
+void UserSettings::save(std::string path, json_t *rootJ) {
+	SettingsState *s = state();
+	std::lock_guard<std::mutex> lock(s->mutex);
+	SettingsFile &f = s->files[path];
+	if (f.rootJ)
+		json_decref(f.rootJ);
+	f.rootJ = rootJ;
+	f.error.text[0] = 0;
+	f.dirty = true;
+	s->pending = true;
+	if (!s->thread.joinable() && !s->stopping)
+		s->thread = std::thread(&SettingsState::run, s);
+	s->wake.notify_one();
+}
@@ -130,6 +130,8 @@ struct BulkParamWidget : widget::OpaqueWidget {
 	virtual void randomize() {}
 
 	std::function<void(ui::Menu *)> contextMenuCallback;
+	/** Replaces the label and value in the tooltip and context menu if set */
+	std::function<std::string()> getText;
 
 	std::string getString();
 	float getDisplayValue();
@@ -358,6 +360,20 @@ private:
 
 extern Scheme gScheme;
 
+//////////////////
+// User Settings
+//////////////////
+
+// Settings files in the Rack user folder are read once and kept in memory. load() returns a 
+// copy of the cached contents, or NULL with error->text set if the file can't be parsed, or 
+// NULL with error->text empty if it doesn't exist. save() takes ownership of rootJ; writes are 
+// made from a background thread, and saves in quick succession are written once.
+
+namespace UserSettings {
+	json_t *load(std::string path, json_error_t *error);
+	void save(std::string path, json_t *rootJ);
+}
+
 struct SchemeCanvasWidget; 
 
 //////////////////
@@ -23,6 +23,9 @@ void BasePort::raiseError(unsigned int errorType) {
 		case ERROR_CHECKSUM:
 			if (dbg) DEBUG("Torpedo Error: CHECKSUM");
 			break;
+		case ERROR_OVERSIZE:
+			if (dbg) DEBUG("Torpedo Error: OVERSIZE");
+			break;
 	}
 	error(errorType);
 }
@@ -40,7 +43,11 @@ void RawOutputPort::completed(void) {
 void RawOutputPort::process(void) {
 	unsigned int channels = hiSpeed?16:1;
 	_module->outputs[_portNum].setChannels(channels);
-	for (unsigned int channel = 0; channel < channels; channel++) {
+	processLane(0, channels);
+}
+
+void RawOutputPort::processLane(unsigned int first, unsigned int count) {
+	for (unsigned int channel = first; channel < first + count; channel++) {
 		int portValue = 0;
 		switch (_state) {
 			case STATE_HEADER:
@@ -64,6 +71,9 @@ void RawOutputPort::process(void) {
 						_counter++;
 						break;
 					case 8:
+						portValue = 0x1000 | (_counter * 0x100) | (wide?FLAG_WIDE:0);
+						_counter++;
+						break;
 					case 9:
 					case 10:
 					case 11:
@@ -76,15 +86,28 @@ void RawOutputPort::process(void) {
 					case 15:
 						portValue = 0x1000 | (_counter * 0x100);
 						_counter = 0;
+						_wide = wide;
 						_state = STATE_BODY;
 				}
 				addCheckSum(portValue & 0xff, _counter + 3);
 				break;
 			case STATE_BODY:
-				portValue = 0x2000 | ((_counter % 0x10) * 0x100) | _message[_counter];
-				addCheckSum(portValue & 0xff, _counter);
-				_counter++;
-				if (_counter == _message.length()) {
+				if (_wide) {
+					// Two bytes per channel-sample; bits 16-23 carry the second byte, which is 
+					// zero after the last byte of an odd length message.
+					unsigned int low = (unsigned char)_message[_counter];
+					unsigned int high = (_counter + 1 < _message.length())?(unsigned char)_message[_counter + 1]:0;
+					portValue = (high << 16) | 0x4000 | (((_counter / 2) % 0x10) * 0x100) | low;
+					addCheckSum(low, _counter);
+					addCheckSum(high, _counter + 1);
+					_counter += 2;
+				}
+				else {
+					portValue = 0x2000 | ((_counter % 0x10) * 0x100) | (unsigned char)_message[_counter];
+					addCheckSum(portValue & 0xff, _counter);
+					_counter++;
+				}
+				if (_counter >= _message.length()) {
 					_counter = 0;
 					_state = STATE_TRAILER;
 				}
@@ -124,12 +147,12 @@ void RawOutputPort::process(void) {
 	}
 }
 
-void RawOutputPort::send(std::string appId, std::string message) {
+void RawOutputPort::send(const std::string &appId, const std::string &message) {
 	_appId.assign(appId);
 	send(message);
 }
 
-void RawOutputPort::send(std::string message) {
+void RawOutputPort::send(const std::string &message) {
 	if (!_module->outputs[_portNum].isConnected()) return;
 	if (!message.length()) {
 		raiseError(ERROR_LENGTH);
@@ -152,197 +175,411 @@ void RawOutputPort::send(std::string message) {
 	_counter = 0;
 }
 
+RawInputPort::RawInputPort(Module *module, unsigned int portNum, RawInputPort *owner) : BasePort(module, portNum) {
+	_owner = owner;
+	if (owner)
+		return;
+	for (unsigned int i = 1; i < MAX_LANES; i++)
+		_lanes.emplace_back(new RawInputPort(module, portNum, this));
+}
+
+void RawInputPort::error(unsigned int errorType) {
+	if (_owner)
+		_owner->error(errorType);
+}
+
 void RawInputPort::process(void) {
 	if (!_module->inputs[_portNum].isConnected()) {
-		_state = STATE_QUIESCENT;
-		_checksum = 0;
+		reset();
+		for (std::unique_ptr<RawInputPort> &lane : _lanes)
+			lane->reset();
 		return;
 	}
 	unsigned int channels = _module->inputs[_portNum].getChannels();
-	for (unsigned int channel = 0; channel < channels; channel++) {
-		unsigned int data = (unsigned int)(_module->inputs[_portNum].getVoltage(channel));
-		if ((data & 0xff00) == 0x3f00) {
-			_state = STATE_QUIESCENT;
-			_checksum = 0;
-			return;
-		}
-		unsigned int state = data >> 12;
-		unsigned int counter = (data & 0x0f00) >> 8;
-		data &= 0xff;
-		switch (_state) {
-			case STATE_QUIESCENT:
-				if (!state) {
-					return;
-				}
-				addCheckSum(data, counter);
-				if (state == 1) {
-					_counter = 0;
-					_message.clear();
-					_state = STATE_HEADER;
-					if (counter != _counter) {
-						raiseError(ERROR_COUNTER);
-						return;
-					}
-					_appId.clear();
-					_appId.push_back(data);
-					_length = 0;
-					continue;
-				}		
+	unsigned int lanes = 0;
+	if (channels == 16) {
+		unsigned int marker = (unsigned int)(_module->inputs[_portNum].getVoltage(0));
+		if ((marker & 0xff00) == LANE_MARKER) {
+			lanes = marker & 0xff;
+			if (!lanes || lanes > MAX_LANES || (15 % lanes)) {
 				raiseError(ERROR_STATE);
 				return;
-			case STATE_HEADER:
-				addCheckSum(data, counter);
-				if (state != _state) {
-					raiseError(ERROR_STATE);
-					return;
-				}
-				_counter++;
+			}
+		}
+	}
+	if (!lanes) {
+		for (unsigned int channel = 0; channel < channels; channel++) {
+			if (!decode((unsigned int)(_module->inputs[_portNum].getVoltage(channel))))
+				return;
+		}
+		return;
+	}
+	// Each lane is decoded separately, by this port for the first lane and by one of the 
+	// lane decoders for the others
+	unsigned int width = 15 / lanes;
+	for (unsigned int lane = 0; lane < lanes; lane++) {
+		RawInputPort *decoder = lane ? _lanes[lane - 1].get() : this;
+		for (unsigned int channel = 1 + lane * width; channel < 1 + (lane + 1) * width; channel++) {
+			if (!decoder->decode((unsigned int)(_module->inputs[_portNum].getVoltage(channel))))
+				break;
+		}
+	}
+}
+
+void RawInputPort::reset() {
+	_state = STATE_QUIESCENT;
+	_checksum = 0;
+}
+
+// Decodes one channel-sample. Returns false if the rest of the sample should be ignored.
+bool RawInputPort::decode(unsigned int data) {
+	const std::string &filter = _owner ? _owner->_filter : _filter;
+	unsigned int limit = _owner ? _owner->_limit : _limit;
+	if ((data & 0xff00) == 0x3f00) {
+		_state = STATE_QUIESCENT;
+		_checksum = 0;
+		return false;
+	}
+	unsigned int state = data >> 12;
+	unsigned int counter = (data & 0x0f00) >> 8;
+	data &= 0xff;
+	switch (_state) {
+		case STATE_QUIESCENT:
+			if (!state) {
+				return false;
+			}
+			addCheckSum(data, counter);
+			if (state == 1) {
+				_counter = 0;
+				_received = 0;
+				_message.clear();
+				_ringWrite = _ringHead;
+				_overflow = false;
+				_wide = false;
+				_skip = false;
+				_oversize = false;
+				_state = STATE_HEADER;
 				if (counter != _counter) {
 					raiseError(ERROR_COUNTER);
-					return;
+					return false;
 				}
-				switch (counter) {
-					case 0:
-					case 1:
-					case 2:
-					case 3:
-						_appId.push_back(data);
-						break;
-					case 4:
-					case 5:
-					case 6:
-					case 7:
-						_length >>= 8;
-						_length += (data << 24);
+				_appId.clear();
+				_appId.push_back(data);
+				_length = 0;
+				return true;
+			}		
+			raiseError(ERROR_STATE);
+			return false;
+		case STATE_HEADER:
+			addCheckSum(data, counter);
+			if (state != _state) {
+				raiseError(ERROR_STATE);
+				return false;
+			}
+			_counter++;
+			if (counter != _counter) {
+				raiseError(ERROR_COUNTER);
+				return false;
+			}
+			switch (counter) {
+				case 0:
+				case 1:
+				case 2:
+				case 3:
+					_appId.push_back(data);
+					break;
+				case 4:
+				case 5:
+				case 6:
+				case 7:
+					_length >>= 8;
+					_length += (data << 24);
+					break;
+				case 8:
+					_wide = data & FLAG_WIDE;
+					break;
+				case 9:
+				case 10:
+				case 11:
+				case 12:
+				case 13:
+				case 14:
+					break;
+				case 15:
+					_state = STATE_BODY;
+					_counter = 0;
+					if (filter.size() && _appId.compare(filter)) {
+						_skip = true;
 						break;
-					case 8:
-					case 9:
-					case 10:
-					case 11:
-					case 12:
-					case 13:
-					case 14:
+					}
+					if (limit && _length > limit) {
+						// Followed to its end, but not stored
+						_skip = true;
+						_oversize = true;
 						break;
-					case 15:
-						_state = STATE_BODY;
+					}
+					if (_ring.size()) {
+						// The app id and length are stored ahead of the message
+						unsigned int space = _ring.size() - (_ringWrite - _ringTail.load(std::memory_order_acquire));
+						_overflow = (space < 8) || (_length > space - 8);
+						if (!_overflow) {
+							for (unsigned int i = 0; i < 4; i++)
+								pushRing(_appId[i]);
+							for (unsigned int i = 0; i < 4; i++)
+								pushRing(_length >> (8 * i));
+						}
+					}
+					else {
 						_message.reserve(_length);
-						_counter = 0;
-						break;
-				}
-				break;
-			case STATE_BODY:
-				addCheckSum(data, counter);
-				if (state != _state) {
+					}
+					break;
+			}
+			break;
+		case STATE_BODY:
+			if (_wide) {
+				// The state nibble is 4, and bits 16-23 carry a second byte
+				if ((state & 0x0f) != 4) {
 					raiseError(ERROR_STATE);
-					return;
+					return false;
 				}
 				if (counter != _counter++) {
 					raiseError(ERROR_COUNTER);
-					return;
+					return false;
 				}
 				_counter %= 16;
-				_message.push_back(data);
-				if (_message.length() >= _length) {
-					_state = STATE_TRAILER;
-					_counter = 0;
-					continue;
+				if (!_skip) {
+					addCheckSum(data, _received);
+					addCheckSum(state >> 4, _received + 1);
+					pushBody(data);
 				}
-				break;
-			case STATE_TRAILER:
+				if (++_received < _length) {
+					if (!_skip)
+						pushBody(state >> 4);
+					_received++;
+				}
+				else if (state >> 4) {
+					raiseError(ERROR_LENGTH);
+					return false;
+				}
+			}
+			else {
+				if (!_skip)
+					addCheckSum(data, counter);
 				if (state != _state) {
 					raiseError(ERROR_STATE);
-					return;
+					return false;
 				}
-				if (counter != _counter) {
+				if (counter != _counter++) {
 					raiseError(ERROR_COUNTER);
-					return;
+					return false;
 				}
-				if (_message.length() != _length) {
-					raiseError(ERROR_LENGTH);
-					return;
-				}
-				if (data != (_checksum & 0xff)) {
-					raiseError(ERROR_CHECKSUM);
-					return;
-				}
-				_checksum >>= 8;
-				_counter++;
-				if (_counter == 4) {
-					_state = STATE_QUIESCENT;
-					_checksum = 0;
-					received(_appId, _message);
+				_counter %= 16;
+				if (!_skip)
+					pushBody(data);
+				_received++;
+			}
+			if (_received >= _length) {
+				_state = STATE_TRAILER;
+				_counter = 0;
+				return true;
+			}
+			break;
+		case STATE_TRAILER:
+			if (state != _state) {
+				raiseError(ERROR_STATE);
+				return false;
+			}
+			if (counter != _counter) {
+				raiseError(ERROR_COUNTER);
+				return false;
+			}
+			if (_received != _length) {
+				raiseError(ERROR_LENGTH);
+				return false;
+			}
+			if (!_skip && data != (_checksum & 0xff)) {
+				raiseError(ERROR_CHECKSUM);
+				return false;
+			}
+			_checksum >>= 8;
+			_counter++;
+			if (_counter == 4) {
+				_state = STATE_QUIESCENT;
+				_checksum = 0;
+				if (_oversize)
+					raiseError(ERROR_OVERSIZE);
+				if (!_skip) {
+					if (!_ring.size())
+						(_owner ? _owner : this)->received(_appId, _message);
+					else if (!_overflow)
+						_ringHead.store(_ringWrite, std::memory_order_release);
+					else if (dbg)
+						DEBUG("Torpedo Dropped: %s %d", _appId.c_str(), _length);
 				}
-				continue;
-		}
+			}
+			return true;
 	}
+
+	return true;
+}
+
+void RawInputPort::pushRing(unsigned int byte) {
+	_ring[_ringWrite++ & (_ring.size() - 1)] = byte;
 }
 
-void RawInputPort::received(std::string appId, std::string message) {
+void RawInputPort::pushBody(unsigned int byte) {
+	if (!_ring.size())
+		_message.push_back(byte);
+	else if (!_overflow)
+		pushRing(byte);
+}
+
+void RawInputPort::defer(unsigned int capacity) {
+	unsigned int size = 1;
+	while (size < capacity)
+		size <<= 1;
+	_ring.resize(size);
+	for (std::unique_ptr<RawInputPort> &lane : _lanes)
+		lane->defer(capacity);
+}
+
+void RawInputPort::limit(unsigned int capacity) {
+	_limit = capacity;
+	_message.reserve(capacity);
+	for (std::unique_ptr<RawInputPort> &lane : _lanes)
+		lane->limit(capacity);
+}
+
+void RawInputPort::dispatch() {
+	drain(this);
+	for (std::unique_ptr<RawInputPort> &lane : _lanes)
+		lane->drain(this);
+}
+
+void RawInputPort::drain(RawInputPort *target) {
+	if (!_ring.size())
+		return;
+	unsigned int mask = _ring.size() - 1;
+	unsigned int tail = _ringTail.load(std::memory_order_relaxed);
+	unsigned int head = _ringHead.load(std::memory_order_acquire);
+	while (tail != head) {
+		std::string appId;
+		for (unsigned int i = 0; i < 4; i++)
+			appId.push_back(_ring[tail++ & mask]);
+		unsigned int length = 0;
+		for (unsigned int i = 0; i < 4; i++)
+			length |= _ring[tail++ & mask] << (8 * i);
+		std::string message;
+		message.reserve(length);
+		for (unsigned int i = 0; i < length; i++)
+			message.push_back(_ring[tail++ & mask]);
+		_ringTail.store(tail, std::memory_order_release);
+		target->received(appId, message);
+	}
+}
+
+void RawInputPort::received(const std::string &appId, const std::string &message) {
 	if (dbg) DEBUG("Torpedo Received:%s %s", appId.c_str(), message.c_str());
 }
 
-void TextInputPort::received(std::string appId, std::string message) {
+void TextInputPort::received(const std::string &appId, const std::string &message) {
 	if (!appId.compare("TEXT"))
 		received(message);
 }
 
 void QueuedOutputPort::abort() {
 	RawOutputPort::abort();
-	for (auto i : _queue) delete i;
-	_queue.clear();
+	_queueHead = 0;
+	_queueCount = 0;
+}
+
+bool QueuedOutputPort::post(const std::string &message) {
+	if (_isPosted.load(std::memory_order_acquire))
+		return false;
+	// Sending it would have to grow the engine's buffer
+	if (message.length() > _capacity) {
+		if (dbg) DEBUG("Torpedo Too Long To Post:");
+		return false;
+	}
+	_posted.assign(message);
+	_isPosted.store(true, std::memory_order_release);
+	return true;
 }
 
 void QueuedOutputPort::process() {
+	if (_isPosted.load(std::memory_order_acquire) && !QueuedOutputPort::isBusy()) {
+		RawOutputPort::send(_posted);
+		_isPosted.store(false, std::memory_order_release);
+	}
 	if (!RawOutputPort::isBusy()) {
-		if (_queue.size()) {
-			std::string *s = _queue.front();
-			_queue.erase(_queue.begin());
-			RawOutputPort::send(std::string(*s));
-			delete s;
+		if (_queueCount) {
+			RawOutputPort::send(_queue[_queueHead]);
+			_queueHead = (_queueHead + 1) % _size;
+			_queueCount--;
 		}
 	}
 	RawOutputPort::process();
 }
 
-void QueuedOutputPort::send(std::string message) {
+void QueuedOutputPort::send(const std::string &message) {
+	// Messages longer than the slots were sized for are refused rather than allocated for
+	if (message.length() > _capacity) {
+		raiseError(ERROR_LENGTH);
+		return;
+	}
 	if (QueuedOutputPort::isBusy()) {
-		if (_queue.size() >= _size) {
-			if (!_replace)
+		if (_queueCount >= _size) {
+			if (!_replace || !_queueCount)
 				return;
-			std::string *s = _queue.back();
-			_queue.pop_back();
-			delete s;
+			_queueCount--;
 			if (dbg) DEBUG("Torpedo Replaced:");
 		}
-		{
-			std::string *s = new std::string(message);
-			_queue.push_back(s);
-			if (dbg) DEBUG("Torpedo Queued:");
-		}
+		_queue[(_queueHead + _queueCount) % _size].assign(message);
+		_queueCount++;
+		if (dbg) DEBUG("Torpedo Queued:");
 		return;
 	}
 	RawOutputPort::send(message);
 }
 
-void QueuedOutputPort::size(unsigned int s) {
+void QueuedOutputPort::size(unsigned int s, unsigned int capacity) {
 	if (s < 1) {
 		return;
 	}
 	_size = s;
+	_capacity = capacity;
+	_queue.resize(s);
+	for (std::string &slot : _queue)
+		slot.reserve(capacity);
+	_queueHead = 0;
+	_queueCount = 0;
+	_message.reserve(capacity);
+	_posted.reserve(capacity);
 }
 
-void MessageOutputPort::send(std::string pluginName, std::string moduleName, std::string message) {
+static std::string encodeMessage(std::string pluginName, std::string moduleName, std::string message) {
 	json_t *rootJ = json_object();
 	json_object_set_new(rootJ, "pluginInstance", json_string(pluginName.c_str()));
 	json_object_set_new(rootJ, "module", json_string(moduleName.c_str()));
 	json_object_set_new(rootJ, "message", json_string(message.c_str()));
 	char *msg = json_dumps(rootJ, 0);
 	json_decref(rootJ);
-	QueuedOutputPort::send(std::string(msg));
+	std::string encoded(msg);
 	free(msg);
+	return encoded;
+}
+
+void MessageOutputPort::send(std::string pluginName, std::string moduleName, std::string message) {
+	QueuedOutputPort::send(encodeMessage(pluginName, moduleName, message));
+}
+
+bool MessageOutputPort::post(std::string pluginName, std::string moduleName, std::string message) {
+	if (!isPostable())
+		return false;
+	return QueuedOutputPort::post(encodeMessage(pluginName, moduleName, message));
 }
 
-void MessageInputPort::received(std::string appId, std::string message) {
+void MessageInputPort::received(const std::string &appId, const std::string &message) {
 	if (dbg) DEBUG("Torpedo Received: %s", message.c_str());
 	std::string pluginName;
 	std::string moduleName;
@@ -369,18 +606,32 @@ void MessageInputPort::received(std::string appId, std::string message) {
 	received(pluginName, moduleName, messageText);
 }
 
-void PatchOutputPort::send(std::string pluginName, std::string moduleName, json_t *rootJ) {
+static std::string encodePatch(std::string pluginName, std::string moduleName, json_t *rootJ) {
 	json_t *wrapper = json_object();
 	json_object_set_new(wrapper, "pluginInstance", json_string(pluginName.c_str()));
 	json_object_set_new(wrapper, "module", json_string(moduleName.c_str()));
 	json_object_set_new(wrapper, "patch", rootJ);
 	char *msg = json_dumps(wrapper, 0);
 	json_decref(wrapper);
-	QueuedOutputPort::send(std::string(msg));
+	std::string encoded(msg);
 	free(msg);
+	return encoded;
+}
+
+void PatchOutputPort::send(std::string pluginName, std::string moduleName, json_t *rootJ) {
+	QueuedOutputPort::send(encodePatch(pluginName, moduleName, rootJ));
+}
+
+// Takes ownership of rootJ, as send() does
+bool PatchOutputPort::post(std::string pluginName, std::string moduleName, json_t *rootJ) {
+	if (!isPostable()) {
+		json_decref(rootJ);
+		return false;
+	}
+	return QueuedOutputPort::post(encodePatch(pluginName, moduleName, rootJ));
 }
 
-void PatchInputPort::received(std::string appId, std::string message) {
+void PatchInputPort::received(const std::string &appId, const std::string &message) {
 	if (dbg) DEBUG("Torpedo Received: %s", message.c_str());
 	std::string pluginName;
 	std::string moduleName;
@@ -1,5 +1,7 @@
 #pragma once
 #include "deque"
+#include <atomic>
+#include <memory>
 using namespace rack;
 
 namespace Torpedo {
@@ -20,16 +22,35 @@ namespace Torpedo {
 			ERROR_STATE,
 			ERROR_COUNTER,
 			ERROR_LENGTH,
-			ERROR_CHECKSUM
+			ERROR_CHECKSUM,
+			ERROR_OVERSIZE
+		};
+
+		// Bits of the flags byte, the first of the reserved header bytes
+		enum Flags {
+			FLAG_WIDE = 0x01
+		};
+
+		// A multiplexed port carries LANE_MARKER on channel 0, with the number of lanes in 
+		// the low byte. Channels 1-15 are shared evenly between the lanes, and each lane is 
+		// a separate stream, so several messages can be sent at once.
+		enum Lanes {
+			LANE_MARKER = 0x3e00,
+			MAX_LANES = 5
 		};
 	
 		unsigned int _checksum = 0;
 		Module *_module;
 		unsigned int _portNum;
 		unsigned int _state = STATE_QUIESCENT;
+		bool _wide = false;
 
 		bool dbg = false;
 		bool hiSpeed = true;
+		// Wide framing carries two bytes in each channel-sample. The body is sent with a 
+		// different state so that receivers that don't understand it drop the message 
+		// rather than misreading it.
+		bool wide = false;
 
 		BasePort(Module *module, unsigned int portNum) {
 			_module = module;
@@ -59,8 +80,9 @@ namespace Torpedo {
 		virtual void appId(std::string app) { _appId.assign(app); }
 		virtual void completed();
 		virtual void process();
-		virtual void send(std::string appId, std::string message);
-		virtual void send(std::string message);
+		void processLane(unsigned int first, unsigned int count);
+		virtual void send(const std::string &appId, const std::string &message);
+		virtual void send(const std::string &message);
 	};
 
 	//
@@ -71,12 +93,48 @@ namespace Torpedo {
 		std::string _appId;
 		unsigned int _counter;
 		unsigned int _length;
+		unsigned int _received;
 		std::string _message;
 
-		RawInputPort(Module *module, unsigned int portNum) : BasePort(module, portNum) {}
-
+		// Only messages with this app id are buffered and passed to received(). Other 
+		// messages are followed to find their end, but their bodies are not stored or 
+		// checksummed. An empty filter accepts every message.
+		std::string _filter;
+		bool _skip = false;
+
+		// Messages longer than the limit are followed, but dropped with ERROR_OVERSIZE, so 
+		// that storage for the longest can be reserved up front by limit(). 0 is no limit.
+		unsigned int _limit = 0;
+		bool _oversize = false;
+
+		// Deferred delivery. The engine thread only copies the bytes of each completed 
+		// message into a ring buffer; dispatch() is then called from the UI thread to pass 
+		// them to received(), so that decoding never holds up the engine.
+		std::vector<unsigned char> _ring;
+		unsigned int _ringWrite = 0;
+		std::atomic<unsigned int> _ringHead { 0 };
+		std::atomic<unsigned int> _ringTail { 0 };
+		bool _overflow = false;
+
+		// Lanes of a multiplexed input after the first are decoded by their own ports, 
+		// which pass what they receive to their owner
+		RawInputPort *_owner;
+		std::vector<std::unique_ptr<RawInputPort>> _lanes;
+
+		RawInputPort(Module *module, unsigned int portNum, RawInputPort *owner = NULL);
+
+		void defer(unsigned int capacity);
+		void dispatch();
+		void limit(unsigned int capacity);
+		void error(unsigned int errorType) override;
 		void process();
-		virtual void received(std::string appId, std::string message);
+		virtual void received(const std::string &appId, const std::string &message);
+		private:
+			bool decode(unsigned int data);
+			void drain(RawInputPort *target);
+			void pushBody(unsigned int byte);
+			void pushRing(unsigned int byte);
+			void reset();
 	};
 
 	//
@@ -84,9 +142,9 @@ namespace Torpedo {
 	//
 
 	struct TextInputPort : RawInputPort {
-		TextInputPort(Module *module, unsigned int portNum) : RawInputPort(module, portNum) {}
+		TextInputPort(Module *module, unsigned int portNum) : RawInputPort(module, portNum) {_filter.assign("TEXT");}
 
-		void received(std::string appId, std::string message) override;
+		void received(const std::string &appId, const std::string &message) override;
 		virtual void received(std::string message) {}
 	};
 
@@ -99,20 +157,32 @@ namespace Torpedo {
 	//
 
 	struct QueuedOutputPort : RawOutputPort {
-		std::vector<std::string *> _queue;
+		// A fixed ring of message slots, allocated by size() with room for messages of up to 
+		// capacity bytes. Slots keep their storage when they are emptied, so queueing a 
+		// message only copies it. Longer messages are refused.
+		std::vector<std::string> _queue;
+		unsigned int _queueHead = 0;
+		unsigned int _queueCount = 0;
 		unsigned int _replace = 0;
 		unsigned int _size = 0;
+		unsigned int _capacity = 0;
+
+		// A single message can be posted from the UI thread, so that it can be encoded 
+		// there. The engine thread sends it once the port is free.
+		std::string _posted;
+		std::atomic<bool> _isPosted { false };
 
 		QueuedOutputPort(Module *module, unsigned int portNum) : RawOutputPort(module, portNum) {}
-		virtual ~QueuedOutputPort() { for (auto i : _queue) delete i; }
 
 		void abort() override;
-		int isBusy() override { return (_state != STATE_QUIESCENT) || _queue.size(); }
-		virtual int isFul() { return _queue.size() >= _size; }
+		int isBusy() override { return (_state != STATE_QUIESCENT) || _queueCount; }
+		virtual int isFul() { return _queueCount >= _size; }
+		bool isPostable() { return !_isPosted; }
+		bool post(const std::string &message);
 		void process() override;
 		void replace(unsigned int rep) { _replace = rep; }
-		void send(std::string message) override;
-		void size(unsigned int s);
+		void send(const std::string &message) override;
+		void size(unsigned int s, unsigned int capacity = 256);
 	};
 
 	//
@@ -123,14 +193,16 @@ namespace Torpedo {
 		MessageOutputPort(Module *module, unsigned int portNum) : QueuedOutputPort(module, portNum) {_appId.assign("MESG");}
 
 		virtual void send(std::string pluginName, std::string moduleName, std::string message);
+		bool post(std::string pluginName, std::string moduleName, std::string message);
 		private:
 			using QueuedOutputPort::send;
+			using QueuedOutputPort::post;
 	};
 
 	struct MessageInputPort : RawInputPort {
-		MessageInputPort(Module *module, unsigned int portNum) : RawInputPort(module, portNum) {}
+		MessageInputPort(Module *module, unsigned int portNum) : RawInputPort(module, portNum) {_filter.assign("MESG");}
 
-		void received(std::string appId, std::string message) override;
+		void received(const std::string &appId, const std::string &message) override;
 		virtual void received(std::string pluginName, std::string moduleName, std::string message) {}
 	};
 
@@ -142,14 +214,16 @@ namespace Torpedo {
 		PatchOutputPort(Module *module, unsigned int portNum) : QueuedOutputPort(module, portNum) {_appId.assign("PTCH");}
 
 		virtual void send(std::string pluginName, std::string moduleName, json_t *rootJ);
+		bool post(std::string pluginName, std::string moduleName, json_t *rootJ);
 		private:
 			using QueuedOutputPort::send;
+			using QueuedOutputPort::post;
 	};
 
 	struct PatchInputPort : RawInputPort {
-		PatchInputPort(Module *module, unsigned int portNum) : RawInputPort(module, portNum) {}
+		PatchInputPort(Module *module, unsigned int portNum) : RawInputPort(module, portNum) {_filter.assign("PTCH");}
 
-		void received(std::string appId, std::string message) override;
+		void received(const std::string &appId, const std::string &message) override;
 		virtual void received(std::string pluginName, std::string moduleName, json_t *rootJ) {}
 	};
 		